@@ -93,7 +93,7 @@ private:
 class my_genotype : public ga4nn::genotype<std::vector<double> > {
 public:
   typedef std::shared_ptr<my_genotype> ptr;
-  explicit my_genotype( ga4nn::neural_net::ptr net_,
+  explicit my_genotype( ga4nn::compiled_net::ptr net_,
                         balance::ptr balance_,
                         double simulation_time_,
                         const std::vector<double> &weights_) :
@@ -108,8 +108,9 @@ public:
     if (m_computed)
       return m_fitval;
 
-    std::vector<double> input(2);
-    m_net->set_weights(get_data());
+    double input[2];
+    double output[1];
+    m_net->bind_weights(get_data());
 
     m_balance->reset();
 
@@ -119,7 +120,7 @@ public:
         time += m_balance->get_dt()) {
       input[0] = m_balance->get_theta();
       input[1] = m_balance->get_deriv_theta();
-      std::vector<double> output = m_net->compute(input);
+      m_net->compute_into(input, 2, output, 1);
       m_balance->accelerate(output[0]);
       double error = 0.0 - m_balance->get_theta();
       m_fitval += (error * error);
@@ -132,7 +133,7 @@ public:
     m_computed = false;
   }
 
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   balance::ptr m_balance;
   double m_simulation_time;
 
@@ -144,7 +145,7 @@ private:
 class my_genotype_creator : public ga4nn::genotype_creator<my_genotype> {
 public:
   typedef std::shared_ptr<my_genotype_creator> ptr;
-  my_genotype_creator(ga4nn::neural_net::ptr net_,
+  my_genotype_creator(ga4nn::compiled_net::ptr net_,
                       balance::ptr balance_,
                       double simulation_time_,
                       double lower_bound_,
@@ -171,7 +172,7 @@ public:
       weights));
   }
 private:
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   balance::ptr m_balance;
   double m_simulation_time;
   double m_lower_bound;
@@ -179,7 +180,7 @@ private:
   size_t m_size;
 };
 
-class my_population : public ga4nn::rb_population<my_genotype> {
+class my_population : public ga4nn::flat_population<my_genotype> {
 public:
   typedef std::shared_ptr<my_population> ptr;
 };
@@ -338,15 +339,17 @@ int main(int argc, char const *argv[]) {
   net->add_layer(hidden_layer);
   net->add_layer(output_layer);
 
+  ga4nn::compiled_net::ptr compiled = net->compile(true);
+
   my_population::ptr population(new my_population);
 #define RADIAN_FROM_DEGREES(degree) (M_PI * degree / 180.0)
   balance::ptr balance0(new balance(0.2, RADIAN_FROM_DEGREES(10.0), 0.005));
 #undef RADIAN_FROM_DEGREES
 
   my_genotype_creator::ptr genotype_creator(
-    new my_genotype_creator(net, balance0, 1.0,
+    new my_genotype_creator(compiled, balance0, 1.0,
                             -10.0, 10.0,
-                            net->get_weights().size()));
+                            compiled->weight_count()));
 
   ga4nn::fill_population<my_population,my_genotype_creator>(
     population,
@@ -33,6 +33,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "connector.hpp"
 #include "neural_net.hpp"
 #include "neuron_factory.hpp"
+#include "tangent_net.hpp"
 
 #include "genetic.hpp"
 
@@ -61,6 +62,19 @@ public:
     m_theta += m_deriv_theta * m_dt;
   }
 
+  // Moves the tangents of theta and its derivative the way accelerate()
+  // moves the state; call it before accelerate().
+  void accelerate_tangent(double acceleration, double accel_tangent,
+                          double &theta_tangent,
+                          double &deriv_tangent) const {
+    const double g = 9.81;
+    double accel_theta = (g * std::cos(m_theta) * theta_tangent
+      - accel_tangent * std::cos(m_theta)
+      + acceleration * std::sin(m_theta) * theta_tangent) / m_length;
+    deriv_tangent += accel_theta * m_dt;
+    theta_tangent += deriv_tangent * m_dt;
+  }
+
   double get_length() const {
     return m_length;
   }
@@ -93,7 +107,7 @@ private:
 class my_genotype : public ga4nn::genotype<std::vector<double> > {
 public:
   typedef std::shared_ptr<my_genotype> ptr;
-  explicit my_genotype( ga4nn::neural_net::ptr net_,
+  explicit my_genotype( ga4nn::compiled_net::ptr net_,
                         balance::ptr balance_,
                         double simulation_time_,
                         const std::vector<double> &weights_) :
@@ -108,8 +122,9 @@ public:
     if (m_computed)
       return m_fitval;
 
-    std::vector<double> input(2);
-    m_net->set_weights(get_data());
+    double input[2];
+    double output[1];
+    m_net->bind_weights(get_data());
 
     m_balance->reset();
 
@@ -119,7 +134,7 @@ public:
         time += m_balance->get_dt()) {
       input[0] = m_balance->get_theta();
       input[1] = m_balance->get_deriv_theta();
-      std::vector<double> output = m_net->compute(input);
+      m_net->compute_into(input, 2, output, 1);
       m_balance->accelerate(output[0]);
       double error = 0.0 - m_balance->get_theta();
       m_fitval += (error * error);
@@ -132,7 +147,7 @@ public:
     m_computed = false;
   }
 
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   balance::ptr m_balance;
   double m_simulation_time;
 
@@ -144,7 +159,7 @@ private:
 class my_genotype_creator : public ga4nn::genotype_creator<my_genotype> {
 public:
   typedef std::shared_ptr<my_genotype_creator> ptr;
-  my_genotype_creator(ga4nn::neural_net::ptr net_,
+  my_genotype_creator(ga4nn::compiled_net::ptr net_,
                       balance::ptr balance_,
                       double simulation_time_,
                       double lower_bound_,
@@ -171,7 +186,7 @@ public:
       weights));
   }
 private:
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   balance::ptr m_balance;
   double m_simulation_time;
   double m_lower_bound;
@@ -179,7 +194,7 @@ private:
   size_t m_size;
 };
 
-class my_population : public ga4nn::rb_population<my_genotype> {
+class my_population : public ga4nn::flat_population<my_genotype> {
 public:
   typedef std::shared_ptr<my_population> ptr;
 };
@@ -192,15 +207,14 @@ public:
 class my_crossover : public ga4nn::crossover<my_genotype> {
 public:
   typedef std::shared_ptr<my_crossover> ptr;
-  explicit my_crossover(double dx, double lambda0) :
-    m_dx(dx),
+  explicit my_crossover(ga4nn::tangent_net::ptr tangent, double lambda0) :
+    m_tangent(tangent),
     m_lambda0(lambda0) {}
 
   virtual std::vector<my_genotype::ptr> cross(
     const std::vector<my_genotype::ptr> &p) {
     std::vector<my_genotype::ptr> vec(1);
-    std::vector<double> dv(p[0]->get_data().size());
-    double fitness = p[0]->fitness();
+    std::vector<double> dv = gradient(p[0]);
 
     vec[0] = my_genotype::ptr(
       new my_genotype(p[0]->m_net,
@@ -208,11 +222,8 @@ public:
         p[0]->m_simulation_time,
         p[0]->get_data()));
 
-    for (size_t i = 0; i < dv.size(); ++i) {
-      vec[0]->get_data()[i] = p[0]->get_data()[i] + m_dx;
-      vec[0]->reset();
-      dv[i] = (vec[0]->fitness() - fitness) > 0? -1.0: 1.0;
-    }
+    for (size_t i = 0; i < dv.size(); ++i)
+      dv[i] = dv[i] > 0? -1.0: 1.0;
 
     double lambda = m_lambda0;
     const size_t iter_count = 10;
@@ -233,8 +244,42 @@ public:
 
     return vec;
   }
+
 private:
-  double m_dx;
+  // Gradient of the fitness over all weights from one rollout: the
+  // tangent of the net's output is carried through the pendulum and back
+  // into the net's inputs.
+  std::vector<double> gradient(const my_genotype::ptr &g) {
+    const size_t n = g->get_data().size();
+    std::vector<double> grad(n, 0.0);
+    std::vector<double> theta_t(n, 0.0), deriv_t(n, 0.0);
+    std::vector<double> input_t(2 * n), output_t(n);
+    double input[2];
+    double output[1];
+
+    m_tangent->set_weights(g->get_data());
+    m_tangent->seed_genes(0);
+    m_tangent->reset();
+    balance &b = *g->m_balance;
+    b.reset();
+    for (double time = 0.0; time < g->m_simulation_time; time += b.get_dt()) {
+      input[0] = b.get_theta();
+      input[1] = b.get_deriv_theta();
+      for (size_t i = 0; i < n; ++i) {
+        input_t[2 * i] = theta_t[i];
+        input_t[2 * i + 1] = deriv_t[i];
+      }
+      m_tangent->compute(input, &input_t[0], output, &output_t[0]);
+      for (size_t i = 0; i < n; ++i)
+        b.accelerate_tangent(output[0], output_t[i], theta_t[i], deriv_t[i]);
+      b.accelerate(output[0]);
+      for (size_t i = 0; i < n; ++i)
+        grad[i] += 2.0 * b.get_theta() * theta_t[i];
+    }
+    return grad;
+  }
+
+  ga4nn::tangent_net::ptr m_tangent;
   double m_lambda0;
 };
 
@@ -344,15 +389,17 @@ int main(int argc, char const *argv[]) {
   net->add_layer(hidden_layer);
   net->add_layer(output_layer);
 
+  ga4nn::compiled_net::ptr compiled = net->compile(true);
+
   my_population::ptr population(new my_population);
 #define RADIAN_FROM_DEGREES(degree) (M_PI * degree / 180.0)
   balance::ptr balance0(new balance(0.2, RADIAN_FROM_DEGREES(10.0), 0.005));
 #undef RADIAN_FROM_DEGREES
 
   my_genotype_creator::ptr genotype_creator(
-    new my_genotype_creator(net, balance0, 1.0,
+    new my_genotype_creator(compiled, balance0, 1.0,
                             -10.0, 10.0,
-                            net->get_weights().size()));
+                            compiled->weight_count()));
 
   ga4nn::fill_population<my_population,my_genotype_creator>(
     population,
@@ -360,7 +407,8 @@ int main(int argc, char const *argv[]) {
     600);
 
   my_selection::ptr selection(new my_selection);
-  my_crossover::ptr crossover(new my_crossover(0.01, 0.01));
+  my_crossover::ptr crossover(new my_crossover(
+    ga4nn::tangent_net::create(compiled, compiled->weight_count()), 0.01));
   my_mutation::ptr mutation(new my_mutation(5));
   my_stop_function::ptr stop_function(new my_stop_function(100));
 
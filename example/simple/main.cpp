@@ -33,6 +33,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "neural_net.hpp"
 #include "neuron_factory.hpp"
 
+#include "arena_genotype.hpp"
 #include "genetic.hpp"
 
 #define USE_MUTATION 0
@@ -67,87 +68,77 @@ private:
   std::vector<prime> m_prime;
 };
 
-class my_genotype : public ga4nn::genotype<std::vector<double> > {
+class my_genotype : public ga4nn::arena_genotype {
 public:
   typedef std::shared_ptr<my_genotype> ptr;
-  explicit my_genotype( ga4nn::neural_net::ptr net_,
+  explicit my_genotype( ga4nn::compiled_net::ptr net_,
                         my_data::ptr data_,
-                        const std::vector<double> &weights_) :
-    ga4nn::genotype<std::vector<double> >(weights_),
+                        ga4nn::genome_arena &arena) :
+    ga4nn::arena_genotype(arena),
     net(net_),
-    data(data_),
-    m_computed(false),
-    m_fitval(0.0) {}
+    data(data_) {}
 
-  virtual double fitness() {
-    if (m_computed)
-      return m_fitval;
+  ga4nn::compiled_net::ptr net;
+  my_data::ptr data;
 
-    std::vector<double> input(2);
-    net->set_weights(get_data());
+protected:
+  virtual double evaluate() {
+    double input[2];
+    double output[1];
+    net->bind_weights(genes());
 
-    m_fitval = 0.0;
+    double fitval = 0.0;
     double y1 = 0.0;
     for (size_t i = 0; i < data->points(); i++) {
       const my_data::prime &prime = data->get_prime(i);
       input[0] = prime.x;
       input[1] = y1;
-      std::vector<double> output = net->compute(input);
+      net->compute_into(input, 2, output, 1);
       y1 = output[0];
       double error = prime.y - output[0];
-      m_fitval += (error * error);
+      fitval += (error * error);
     }
-    m_computed = true;
-    return m_fitval;
-  }
-
-  void reset() {
-    m_computed = false;
+    return fitval;
   }
-
-  ga4nn::neural_net::ptr net;
-  my_data::ptr data;
-
-private:
-  bool m_computed;
-  double m_fitval;
 };
 
 class my_genotype_creator : public ga4nn::genotype_creator<my_genotype> {
 public:
   typedef std::shared_ptr<my_genotype_creator> ptr;
-  my_genotype_creator(ga4nn::neural_net::ptr net,
+  my_genotype_creator(ga4nn::compiled_net::ptr net,
                       my_data::ptr data,
+                      ga4nn::genome_arena::ptr arena,
                       double lower_bound,
-                      double upper_bound,
-                      size_t size) :
+                      double upper_bound) :
     m_net(net),
     m_data(data),
+    m_arena(arena),
     m_lower_bound(lower_bound),
-    m_upper_bound(upper_bound),
-    m_size(size) { std::srand(std::time(0)); }
+    m_upper_bound(upper_bound) { std::srand(std::time(0)); }
 
   my_genotype::ptr make() {
-    std::vector<double> weights(m_size);
+    my_genotype::ptr g(new my_genotype(m_net, m_data, *m_arena));
     const double precision = 1000.;
-    for (int i = 0; i < m_size; ++i) {
-      weights[i] = (std::rand()
+    for (size_t i = 0; i < g->size(); ++i) {
+      g->genes()[i] = (std::rand()
         % static_cast<int>((m_upper_bound - m_lower_bound) * precision))
         / precision + m_lower_bound;
     }
-    return my_genotype::ptr(new my_genotype(m_net, m_data, weights));
+    return g;
   }
 private:
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   my_data::ptr m_data;
+  ga4nn::genome_arena::ptr m_arena;
   double m_lower_bound;
   double m_upper_bound;
-  size_t m_size;
 };
 
-class my_population : public ga4nn::rb_population<my_genotype> {
+class my_population : public ga4nn::arena_population<my_genotype> {
 public:
   typedef std::shared_ptr<my_population> ptr;
+  explicit my_population(const ga4nn::genome_arena::ptr &arena) :
+    ga4nn::arena_population<my_genotype>(arena) {}
 };
 
 class my_selection : public ga4nn::b_selection<my_population> {
@@ -165,14 +156,13 @@ public:
   virtual std::vector<my_genotype::ptr> cross(
     const std::vector<my_genotype::ptr> &p) {
     std::vector<my_genotype::ptr> vec(1);
-    std::vector<double> dv(p[0]->get_data().size());
+    std::vector<double> dv(p[0]->size());
     double fitness = p[0]->fitness();
 
-    vec[0] = my_genotype::ptr(
-      new my_genotype(p[0]->net, p[0]->data, p[0]->get_data()));
+    vec[0] = my_genotype::ptr(new my_genotype(*p[0]));
 
     for (size_t i = 0; i < dv.size(); ++i) {
-      vec[0]->get_data()[i] = p[0]->get_data()[i] + m_dx;
+      vec[0]->genes()[i] = p[0]->genes()[i] + m_dx;
       vec[0]->reset();
       dv[i] = (vec[0]->fitness() - fitness) > 0? -1.0: 1.0;
     }
@@ -180,8 +170,8 @@ public:
     double lambda = m_lambda0;
     const size_t iter_count = 10;
     for (size_t iter = 0; iter < iter_count; ++iter) {
-      for (size_t i = 0; i < p[0]->get_data().size(); ++i) {
-        vec[0]->get_data()[i] = p[0]->get_data()[i] + lambda * dv[i];
+      for (size_t i = 0; i < p[0]->size(); ++i) {
+        vec[0]->genes()[i] = p[0]->genes()[i] + lambda * dv[i];
       }
       vec[0]->reset();
       if (vec[0]->fitness() < p[0]->fitness())
@@ -190,8 +180,8 @@ public:
     }
 
     if (vec[0]->fitness() > p[0]->fitness()) {
-      for (size_t i = 0; i < p[0]->get_data().size(); ++i)
-        vec[0]->get_data()[i] = p[0]->get_data()[i];
+      for (size_t i = 0; i < p[0]->size(); ++i)
+        vec[0]->genes()[i] = p[0]->genes()[i];
     }
 
     return vec;
@@ -215,11 +205,11 @@ public:
     const int gain = 1000;
     int r = std::rand() % (100 * gain);
     if (r < (m_propability * gain)) {
-      int pos1 = std::rand() % g->get_data().size();
-      int pos2 = std::rand() % g->get_data().size();
-      double tmp = g->get_data()[pos1];
-      g->get_data()[pos1] = g->get_data()[pos2];
-      g->get_data()[pos2] = tmp;
+      int pos1 = std::rand() % g->size();
+      int pos2 = std::rand() % g->size();
+      double tmp = g->genes()[pos1];
+      g->genes()[pos1] = g->genes()[pos2];
+      g->genes()[pos2] = tmp;
     }
     return g;
 #endif
@@ -234,7 +224,8 @@ public:
   typedef std::shared_ptr<my_stop_function> ptr;
   explicit my_stop_function(size_t epoch_number) :
     m_counter(0),
-    m_epoch_number(epoch_number) {}
+    m_epoch_number(epoch_number),
+    m_best_fitness(0.0) {}
 
   virtual bool done(my_population::ptr p) {
     if (m_counter < m_epoch_number) {
@@ -244,36 +235,39 @@ public:
       p->insert(b);
       p->insert(m);
 
-      if (!m_best
-        || (m_best && m_best->fitness() > b->fitness())) {
+      if (m_best.empty() || m_best_fitness > b->fitness()) {
         std::cout << "Epoch number= " << (m_counter + 1)
           << "\tGenotype= " << b->fitness()
           << "(" << m->fitness() << ")" << std::endl;
 
-        m_best = b;
+        // b's arena row is reused two generations on, so keep its genes.
+        m_best.assign(b->genes(), b->genes() + b->size());
+        m_best_fitness = b->fitness();
+        m_net = b->net;
+        m_data = b->data;
       }
 
       ++m_counter;
       return false;
     }
 
-    if (m_best) {
-      m_best->net->set_weights(m_best->get_data());
+    if (!m_best.empty()) {
+      m_net->set_weights(m_best);
       std::vector<double> input(2);
       double y1 = 0.0;
       std::cout << "=== Result ===" << std::endl;
       std::cout << "x\ty" << std::endl;
-      for (size_t i = 0; i < m_best->data->points(); i++) {
-        const my_data::prime &prime = m_best->data->get_prime(i);
+      for (size_t i = 0; i < m_data->points(); i++) {
+        const my_data::prime &prime = m_data->get_prime(i);
         input[0] = prime.x;
         input[1] = y1;
-        std::vector<double> output = m_best->net->compute(input);
+        std::vector<double> output = m_net->compute(input);
         y1 = output[0];
         std::cout << prime.x << "\t" << output[0] << std::endl;
       }
 
-      for (size_t i = 0; i < m_best->get_data().size(); i++) {
-        std::cout << m_best->get_data()[i] << std::endl;
+      for (size_t i = 0; i < m_best.size(); i++) {
+        std::cout << m_best[i] << std::endl;
       }
     }
 
@@ -282,7 +276,10 @@ public:
 private:
   size_t m_counter;
   size_t m_epoch_number;
-  my_genotype::ptr m_best;
+  std::vector<double> m_best;
+  double m_best_fitness;
+  ga4nn::compiled_net::ptr m_net;
+  my_data::ptr m_data;
 };
 
 int main(int argc, char const *argv[]) {
@@ -304,7 +301,12 @@ int main(int argc, char const *argv[]) {
   net->add_layer(hidden_layer);
   net->add_layer(output_layer);
 
-  my_population::ptr population(new my_population);
+  ga4nn::compiled_net::ptr compiled = net->compile(true);
+
+  const size_t population_size = 600;
+  ga4nn::genome_arena::ptr arena =
+    ga4nn::genome_arena::create(population_size, compiled->weight_count());
+  my_population::ptr population(new my_population(arena));
   my_data::ptr data(new my_data(0.01, 0.001, 100));
   std::cout << "=== Data ===" << std::endl;
   std::cout << "x\ty" << std::endl;
@@ -313,14 +315,13 @@ int main(int argc, char const *argv[]) {
     std::cout << p.x << "\t" << p.y << std::endl;
   }
   my_genotype_creator::ptr genotype_creator(
-    new my_genotype_creator(net, data,
-                            -1.0, 1.0,
-                            net->get_weights().size()));
+    new my_genotype_creator(compiled, data, arena,
+                            -1.0, 1.0));
 
   ga4nn::fill_population<my_population,my_genotype_creator>(
     population,
     genotype_creator,
-    600);
+    population_size);
 
   my_selection::ptr selection(new my_selection);
   my_crossover::ptr crossover(new my_crossover(0.01, 0.01));
@@ -34,6 +34,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "neuron_factory.hpp"
 
 #include "genetic.hpp"
+#include "gradient_mutation.hpp"
 
 class my_data {
 public:
@@ -46,24 +47,33 @@ public:
     prime(double x1_, double x2_, double y_) : x1(x1_), x2(x2_), y(y_) {}
   };
 
-  my_data() : m_prime(4) {
+  my_data() : m_prime(4), m_input(8), m_target(4) {
     m_prime[0] = prime(0, 0, 0);
     m_prime[1] = prime(0, 1, 1);
     m_prime[2] = prime(1, 1, 0);
     m_prime[3] = prime(1, 0, 1);
+    for (size_t i = 0; i < m_prime.size(); i++) {
+      m_input[2 * i] = m_prime[i].x1;
+      m_input[2 * i + 1] = m_prime[i].x2;
+      m_target[i] = m_prime[i].y;
+    }
   }
 
   size_t points() const { return m_prime.size(); }
   const prime &get_prime(size_t index) const { return m_prime[index]; }
+  const std::vector<double> &get_input() const { return m_input; }
+  const std::vector<double> &get_target() const { return m_target; }
 
 private:
   std::vector<prime> m_prime;
+  std::vector<double> m_input;
+  std::vector<double> m_target;
 };
 
 class my_genotype : public ga4nn::genotype<std::vector<double> > {
 public:
   typedef std::shared_ptr<my_genotype> ptr;
-  explicit my_genotype( ga4nn::neural_net::ptr net_,
+  explicit my_genotype( ga4nn::compiled_net::ptr net_,
                         my_data::ptr data_,
                         const std::vector<double> &weights_) :
     ga4nn::genotype<std::vector<double> >(weights_),
@@ -76,23 +86,24 @@ public:
     if (m_computed)
       return m_fitval;
 
-    std::vector<double> input(2);
-    net->set_weights(get_data());
+    // One context per thread, so children can be scored concurrently.
+    static thread_local ga4nn::compiled_net::context::ptr ctx;
+    if (!ctx)
+      ctx = net->make_context();
+    std::vector<double> output;
+    net->bind_weights(*ctx, get_data());
+    net->compute_batch(*ctx, data->get_input(), output);
 
     m_fitval = 0.0;
     for (size_t i = 0; i < data->points(); i++) {
-      const my_data::prime &prime = data->get_prime(i);
-      input[0] = prime.x1;
-      input[1] = prime.x2;
-      std::vector<double> output = net->compute(input);
-      double error = prime.y - output[0];
+      double error = data->get_prime(i).y - output[i];
       m_fitval += (error * error);
     }
     m_computed = true;
     return m_fitval;
   }
 
-  ga4nn::neural_net::ptr net;
+  ga4nn::compiled_net::ptr net;
   my_data::ptr data;
 
 private:
@@ -103,7 +114,7 @@ private:
 class my_genotype_creator : public ga4nn::genotype_creator<my_genotype> {
 public:
   typedef std::shared_ptr<my_genotype_creator> ptr;
-  my_genotype_creator(ga4nn::neural_net::ptr net,
+  my_genotype_creator(ga4nn::compiled_net::ptr net,
                       my_data::ptr data,
                       double lower_bound,
                       double upper_bound,
@@ -125,14 +136,14 @@ public:
     return my_genotype::ptr(new my_genotype(m_net, m_data, weights));
   }
 private:
-  ga4nn::neural_net::ptr m_net;
+  ga4nn::compiled_net::ptr m_net;
   my_data::ptr m_data;
   double m_lower_bound;
   double m_upper_bound;
   size_t m_size;
 };
 
-class my_population : public ga4nn::rb_population<my_genotype> {
+class my_population : public ga4nn::flat_population<my_genotype> {
 public:
   typedef std::shared_ptr<my_population> ptr;
 };
@@ -193,27 +204,14 @@ private:
   double m_gain;
 };
 
-class my_mutation : public ga4nn::mutation<my_genotype> {
+// Each child takes a few gradient steps on the data before insertion.
+class my_mutation : public ga4nn::gradient_mutation<my_genotype> {
 public:
   typedef std::shared_ptr<my_mutation> ptr;
-  explicit my_mutation(int propability_perc) :
-    m_propability(propability_perc) { std::srand(std::time(0)); }
-
-  virtual my_genotype::ptr mutate(my_genotype::ptr g) {
-    const int gain = 1000;
-    int r = std::rand() % (100 * gain);
-    if (r < (m_propability * gain)) {
-      int pos1 = std::rand() % g->get_data().size();
-      int pos2 = std::rand() % g->get_data().size();
-      double tmp = g->get_data()[pos1];
-      g->get_data()[pos1] = g->get_data()[pos2];
-      g->get_data()[pos2] = tmp;
-    }
-    return g;
-  }
-
-private:
-  int m_propability;
+  my_mutation(ga4nn::compiled_net::ptr net, my_data::ptr data) :
+    ga4nn::gradient_mutation<my_genotype>(ga4nn::gradient_net::create(net),
+                                          data->get_input(),
+                                          data->get_target(), 5, 0.5) {}
 };
 
 class my_stop_function : public ga4nn::stop_function<my_population> {
@@ -287,6 +285,8 @@ int main(int argc, char const *argv[]) {
   net->add_layer(hidden_layer);
   net->add_layer(output_layer);
 
+  ga4nn::compiled_net::ptr compiled = net->compile();
+
   my_population::ptr population(new my_population);
   my_data::ptr data(new my_data());
   std::cout << "=== Data ===" << std::endl;
@@ -296,18 +296,20 @@ int main(int argc, char const *argv[]) {
     std::cout << p.x1 << "\t" << p.x2 << "\t" << p.y << std::endl;
   }
   my_genotype_creator::ptr genotype_creator(
-    new my_genotype_creator(net, data,
+    new my_genotype_creator(compiled, data,
                             -10.0, 10.0,
-                            net->get_weights().size()));
+                            compiled->weight_count()));
 
+  ga4nn::thread_pool::ptr pool(new ga4nn::thread_pool);
   ga4nn::fill_population<my_population,my_genotype_creator>(
     population,
     genotype_creator,
-    1000);
+    1000,
+    pool);
 
   my_selection::ptr selection(new my_selection);
   my_crossover::ptr crossover(new my_crossover(-10.0, 10.0, 0.002));
-  my_mutation::ptr mutation(new my_mutation(5));
+  my_mutation::ptr mutation(new my_mutation(compiled, data));
   my_stop_function::ptr stop_function(new my_stop_function(1000));
 
   std::cout << "=== Evolve ===" << std::endl;
@@ -318,7 +320,7 @@ int main(int argc, char const *argv[]) {
     my_crossover,
     my_mutation,
     my_stop_function
-    >(population, selection, crossover, mutation, stop_function);
+    >(population, selection, crossover, mutation, stop_function, pool);
 
   return 0;
 }
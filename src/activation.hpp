@@ -0,0 +1,42 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __ACTIVATION_HPP
+#define __ACTIVATION_HPP
+#include <cstdlib>
+
+namespace ga4nn {
+// Activation policies for typed_layer. apply() is a static inline function,
+// so the activation is compiled into the layer's loop instead of being
+// reached through a virtual call per neuron.
+struct softsign_function {
+  static double apply(double z) { return z / (1 + (z < 0 ? -z : z)); }
+};
+
+struct identity_function {
+  static double apply(double z) { return z; }
+};
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace ga4nn {
+namespace {
+size_t padding(const char *p, size_t alignment) {
+  return (alignment - reinterpret_cast<std::uintptr_t>(p) % alignment)
+    % alignment;
+}
+}
+
+struct arena::prv {
+  size_t block_size;
+  std::vector<char *> blocks;
+  char *current;
+  size_t left;
+  size_t allocated;
+
+  explicit prv(size_t block_size_) :
+    block_size(block_size_), current(0), left(0), allocated(0) {}
+  ~prv() {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      ::operator delete(blocks[i]);
+  }
+
+  char *new_block(size_t size) {
+    char *p = static_cast<char *>(::operator new(size));
+    blocks.push_back(p);
+    return p;
+  }
+};
+
+arena::arena(size_t block_size) :
+  d(new prv(std::max<size_t>(block_size, 64))) {}
+arena::~arena() {}
+
+void *arena::allocate(size_t size, size_t alignment) {
+  d->allocated += size;
+  // Oversized requests get a block of their own so the current block keeps
+  // serving small ones.
+  if (size + alignment > d->block_size) {
+    char *p = d->new_block(size + alignment);
+    return p + padding(p, alignment);
+  }
+  size_t pad = d->current ? padding(d->current, alignment) : 0;
+  if (!d->current || pad + size > d->left) {
+    d->current = d->new_block(d->block_size);
+    d->left = d->block_size;
+    pad = padding(d->current, alignment);
+  }
+  void *result = d->current + pad;
+  d->current += pad + size;
+  d->left -= pad + size;
+  return result;
+}
+
+size_t arena::block_count() const { return d->blocks.size(); }
+
+size_t arena::bytes_allocated() const { return d->allocated; }
+}
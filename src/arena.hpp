@@ -0,0 +1,100 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __ARENA_HPP
+#define __ARENA_HPP
+#include <cstdlib>
+#include <memory>
+#include <utility>
+
+namespace ga4nn {
+// Bump allocator for the objects of one net. Memory is taken from a few
+// large blocks and only returned when the arena itself is destroyed;
+// individual deallocations are no-ops. Not thread-safe: build a net from
+// one thread at a time.
+class arena {
+public:
+  typedef typename std::shared_ptr<arena> ptr;
+  explicit arena(size_t block_size = 64 * 1024);
+  ~arena();
+
+  void *allocate(size_t size, size_t alignment);
+
+  size_t block_count() const;
+  size_t bytes_allocated() const;
+
+private:
+  arena(const arena &) = delete;
+  arena &operator=(const arena &) = delete;
+
+  struct prv;
+  std::shared_ptr<prv> d;
+};
+
+// Standard allocator on top of an arena. Every object made with it holds
+// a reference to the arena through its control block, so the arena lives
+// as long as the last of them, whichever layer or net it came from.
+template <class T>
+class arena_allocator {
+public:
+  typedef T value_type;
+
+  explicit arena_allocator(const arena::ptr &a) : m_arena(a) {}
+  template <class U>
+  arena_allocator(const arena_allocator<U> &other) :
+    m_arena(other.get_arena()) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  const arena::ptr &get_arena() const { return m_arena; }
+
+private:
+  arena::ptr m_arena;
+};
+
+template <class T, class U>
+bool operator==(const arena_allocator<T> &a, const arena_allocator<U> &b) {
+  return a.get_arena() == b.get_arena();
+}
+
+template <class T, class U>
+bool operator!=(const arena_allocator<T> &a, const arena_allocator<U> &b) {
+  return !(a == b);
+}
+
+// Object and reference counts in a single allocation, taken from the arena
+// when there is one and from the heap otherwise.
+template <class T, class... Args>
+std::shared_ptr<T> make_shared_in(const arena::ptr &a, Args &&... args) {
+  if (a)
+    return std::allocate_shared<T>(arena_allocator<T>(a),
+                                   std::forward<Args>(args)...);
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
+}
+
+#endif
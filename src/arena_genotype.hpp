@@ -0,0 +1,110 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __ARENA_GENOTYPE_HPP
+#define __ARENA_GENOTYPE_HPP
+#include <cstdlib>
+
+#include <algorithm>
+#include <memory>
+
+#include "genome_arena.hpp"
+#include "genotype.hpp"
+#include "population.hpp"
+
+namespace ga4nn {
+// Genotype whose genes, fitness and flags live in a genome_arena row. It
+// is made as a child and becomes a parent when its population begins the
+// next generation; a generation later its row is reused, so copy out the
+// genes of a genotype kept longer than that. Such a genotype is no longer
+// valid() and asserts on use in debug builds. Crossovers must make new
+// children (construct or copy, never hand a parent on) and from one
+// thread, as add_child() is not thread-safe. The arena must outlive it.
+class arena_genotype : public genotype<genome_arena::slot> {
+public:
+  typedef std::shared_ptr<arena_genotype> ptr;
+  explicit arena_genotype(genome_arena &arena) :
+    genotype<genome_arena::slot>(arena.add_child()),
+    m_arena(&arena) {}
+
+  // A copy is a new child with the same genes and fitness.
+  arena_genotype(const arena_genotype &other) :
+    genotype<genome_arena::slot>(other.m_arena->add_child()),
+    m_arena(other.m_arena) {
+    std::copy(other.genes(), other.genes() + size(), genes());
+    m_arena->set_flags(m_data, m_arena->flags(other.m_data));
+    if (m_arena->flags(m_data) & genome_arena::scored)
+      m_arena->set_fitness(m_data, m_arena->fitness(other.m_data));
+  }
+  virtual ~arena_genotype() {}
+
+  bool valid() const { return m_arena->valid(m_data); }
+  size_t size() const { return m_arena->genes(); }
+  double *genes() { return m_arena->genome(m_data); }
+  const double *genes() const { return m_arena->genome(m_data); }
+
+  virtual double fitness() {
+    if (m_arena->flags(m_data) & genome_arena::scored)
+      return m_arena->fitness(m_data);
+    double f = evaluate();
+    m_arena->set_fitness(m_data, f);
+    return f;
+  }
+
+  // Forgets the fitness after the genes changed.
+  void reset() {
+    unsigned flags = m_arena->flags(m_data);
+    m_arena->set_flags(m_data, flags & ~unsigned(genome_arena::scored));
+  }
+
+protected:
+  virtual double evaluate() = 0;
+
+private:
+  arena_genotype &operator=(const arena_genotype &) = delete;
+
+  genome_arena *m_arena;
+};
+
+// flat_population of arena genotypes that swaps the arena's generations
+// when evolve() begins a new one. Island models keep a population per
+// island and so can't share an arena; use it with evolve() only.
+template<class Genotype>
+class arena_population : public flat_population<Genotype> {
+public:
+  typedef typename std::shared_ptr<arena_population> ptr;
+  explicit arena_population(const genome_arena::ptr &arena) :
+    m_arena(arena) {}
+  virtual ~arena_population() {}
+
+  genome_arena &get_genome_arena() const { return *m_arena; }
+
+  void begin_generation() { m_arena->swap(); }
+
+private:
+  genome_arena::ptr m_arena;
+};
+}
+
+#endif
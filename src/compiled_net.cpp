@@ -0,0 +1,935 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "compiled_net.hpp"
+
+#include <algorithm>
+#include <map>
+
+#include "kernel.hpp"
+#include "neural_net.hpp"
+
+namespace ga4nn {
+namespace {
+const size_t no_block = static_cast<size_t>(-1);
+
+struct neuron_slot {
+  size_t layer;
+  size_t index;
+};
+
+bool classify(const neuron::ptr &n, compiled_net::activation &kind,
+              size_t &history_len) {
+  history_len = 0;
+  if (std::dynamic_pointer_cast<input_neuron>(n)) {
+    kind = compiled_net::input_activation;
+  } else if (std::dynamic_pointer_cast<sigmoid_neuron>(n)) {
+    kind = compiled_net::softsign_activation;
+  } else if (std::dynamic_pointer_cast<linear_neuron>(n)) {
+    kind = compiled_net::linear_activation;
+  } else if (std::shared_ptr<feedback_neuron> f =
+                 std::dynamic_pointer_cast<feedback_neuron>(n)) {
+    kind = compiled_net::feedback_activation;
+    history_len = f->history_length();
+  } else {
+    return false;
+  }
+  return true;
+}
+}
+
+compiled_net::compiled_net() :
+  m_outputs(0),
+  m_history(0),
+  m_widest(0),
+  m_feedforward(true),
+  m_all_direct(true),
+  m_kernels(&best_kernels()) {}
+
+compiled_net::ptr compiled_net::compile(const neural_net &net,
+                                        double sparse_density,
+                                        bool optimize) {
+  if (net.layer_count() < 2)
+    return ptr();
+
+  ptr c(new compiled_net);
+  std::map<const neuron *, neuron_slot> slots;
+  size_t outputs = 0;
+  size_t widest = 0;
+  for (size_t i = 0; i < net.layer_count(); ++i) {
+    layer::ptr l = net.get_layer(i);
+    layer_plan plan;
+    plan.size = l->neuron_count();
+    plan.offset = outputs;
+    plan.computed = false;
+    plan.lateral = false;
+    for (size_t j = 0; j < plan.size; ++j) {
+      neuron_slot slot = { i, j };
+      slots[l->get_neuron(j).get()] = slot;
+    }
+    outputs += plan.size;
+    widest = std::max(widest, plan.size);
+    c->m_layer.push_back(plan);
+  }
+
+  // Activation spans, delay lines and the set of source layers per layer.
+  size_t history = 0;
+  for (size_t i = 0; i < c->m_layer.size(); ++i) {
+    layer::ptr l = net.get_layer(i);
+    layer_plan &plan = c->m_layer[i];
+    std::vector<size_t> block_of(c->m_layer.size(), c->m_layer.size());
+    for (size_t j = 0; j < plan.size; ++j) {
+      neuron::ptr n = l->get_neuron(j);
+      activation kind;
+      size_t history_len;
+      if (!classify(n, kind, history_len))
+        return ptr();
+      if (plan.spans.empty() || plan.spans.back().kind != kind) {
+        span s = { j, j + 1, kind };
+        plan.spans.push_back(s);
+      } else {
+        plan.spans.back().last = j + 1;
+      }
+      if (kind != input_activation)
+        plan.computed = true;
+      if (kind == feedback_activation) {
+        c->m_feedforward = false;
+        delay_line d = { j, history, history_len };
+        plan.delays.push_back(d);
+        history += history_len;
+      }
+      for (size_t k = 0; k < n->link_count(); ++k) {
+        std::map<const neuron *, neuron_slot>::const_iterator it =
+            slots.find(n->get_link(k)->neuron_back.get());
+        if (it == slots.end())
+          return ptr();
+        size_t source = it->second.layer;
+        if (source >= i)
+          c->m_feedforward = false;
+        if (block_of[source] == c->m_layer.size()) {
+          block_of[source] = plan.blocks.size();
+          block b = { 0, source, plan.size, c->m_layer[source].size, 0,
+                      0, false, 0, false, false, 0 };
+          plan.blocks.push_back(b);
+        }
+        // Links to earlier neurons of the same layer would see this step's
+        // outputs, which a block product cannot reproduce.
+        if (source == i) {
+          if (it->second.index < j)
+            return ptr();
+          plan.lateral = true;
+        }
+      }
+    }
+  }
+
+  // Which entries of each block are linked, to pick dense or CSR storage.
+  // When optimizing, constant links of weight 0 are left out and blocks
+  // made only of constant unit links become copies.
+  size_t block_count = 0;
+  std::vector<std::vector<bool> > linked;
+  std::vector<bool> unit;
+  for (size_t i = 0; i < c->m_layer.size(); ++i) {
+    layer::ptr l = net.get_layer(i);
+    std::vector<block> &blocks = c->m_layer[i].blocks;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      blocks[b].index = block_count++;
+      linked.push_back(std::vector<bool>(blocks[b].rows * blocks[b].cols));
+      unit.push_back(optimize);
+    }
+    for (size_t j = 0; j < c->m_layer[i].size; ++j) {
+      neuron::ptr n = l->get_neuron(j);
+      for (size_t k = 0; k < n->link_count(); ++k) {
+        neuron::link::ptr link = n->get_link(k);
+        const neuron_slot &back = slots[link->neuron_back.get()];
+        size_t b = 0;
+        while (blocks[b].source != back.layer)
+          ++b;
+        std::vector<bool> &entries = linked[blocks[b].index];
+        size_t e = j * blocks[b].cols + back.index;
+        if (entries[e])
+          return ptr();
+        if (optimize && link->constant && link->weight == 0.0)
+          continue;
+        if (!link->constant || link->weight != 1.0)
+          unit[blocks[b].index] = false;
+        entries[e] = true;
+        ++blocks[b].entries;
+      }
+    }
+  }
+
+  // slot[block][row * cols + col] is the entry's position in the block.
+  size_t matrix = 0;
+  std::vector<std::vector<size_t> > slot(block_count);
+  for (size_t i = 0; i < c->m_layer.size(); ++i) {
+    std::vector<block> &blocks = c->m_layer[i].blocks;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      block &bl = blocks[b];
+      const std::vector<bool> &entries = linked[bl.index];
+      size_t size = bl.rows * bl.cols;
+      std::vector<size_t> &at = slot[bl.index];
+      at.resize(size);
+      bl.copy = unit[bl.index];
+      for (size_t r = 0; r < bl.rows && bl.copy; ++r)
+        bl.copy = std::count(entries.begin() + r * bl.cols,
+                             entries.begin() + (r + 1) * bl.cols, true) < 2;
+      bl.sparse = bl.copy || bl.entries < sparse_density * size;
+      if (bl.sparse) {
+        bl.pattern = c->m_pattern.size();
+        c->m_pattern.resize(bl.pattern + bl.rows + 1 + bl.entries);
+        size_t *row = &c->m_pattern[bl.pattern];
+        size_t *col = row + bl.rows + 1;
+        size_t e = 0;
+        for (size_t r = 0; r < bl.rows; ++r) {
+          row[r] = e;
+          for (size_t k = 0; k < bl.cols; ++k) {
+            if (!entries[r * bl.cols + k])
+              continue;
+            at[r * bl.cols + k] = e;
+            col[e++] = k;
+          }
+        }
+        row[bl.rows] = e;
+      } else {
+        bl.entries = size;
+        for (size_t e = 0; e < size; ++e)
+          at[e] = e;
+      }
+      bl.offset = matrix;
+      matrix += bl.entries;
+    }
+  }
+  c->m_matrix.assign(matrix, 0.0);
+
+  // Weights and the genome layout, in neural_net::get_weights() order.
+  for (size_t i = 0; i < c->m_layer.size(); ++i) {
+    layer::ptr l = net.get_layer(i);
+    const layer_plan &plan = c->m_layer[i];
+    for (size_t j = 0; j < plan.size; ++j) {
+      neuron::ptr n = l->get_neuron(j);
+      for (size_t k = 0; k < n->link_count(); ++k) {
+        neuron::link::ptr link = n->get_link(k);
+        const neuron_slot &back = slots[link->neuron_back.get()];
+        size_t b = 0;
+        while (plan.blocks[b].source != back.layer)
+          ++b;
+        const block &bl = plan.blocks[b];
+        if (!linked[bl.index][j * bl.cols + back.index])
+          continue;
+        size_t offset = bl.offset + slot[bl.index][j * bl.cols + back.index];
+        c->m_matrix[offset] = link->weight;
+        if (!link->constant)
+          c->m_gene.push_back(offset);
+      }
+    }
+  }
+
+  std::vector<size_t> gene_at(matrix, c->m_gene.size());
+  for (size_t g = 0; g < c->m_gene.size(); ++g)
+    gene_at[c->m_gene[g]] = g;
+  std::vector<bool> in_direct(matrix, false);
+  for (size_t i = 0; i < c->m_layer.size(); ++i) {
+    std::vector<block> &blocks = c->m_layer[i].blocks;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      block &bl = blocks[b];
+      size_t size = bl.entries;
+      bl.gene = size ? gene_at[bl.offset] : 0;
+      bl.direct = true;
+      for (size_t e = 0; e < size && bl.direct; ++e)
+        bl.direct = bl.gene + e < c->m_gene.size()
+          && gene_at[bl.offset + e] == bl.gene + e;
+      if (bl.direct)
+        std::fill(in_direct.begin() + bl.offset,
+                  in_direct.begin() + bl.offset + size, true);
+      else
+        c->m_all_direct = false;
+    }
+  }
+  for (size_t g = 0; g < c->m_gene.size(); ++g)
+    if (!in_direct[c->m_gene[g]])
+      c->m_scatter.push_back(g);
+
+  for (size_t i = 0; i < c->m_layer.size(); ++i)
+    c->m_block.insert(c->m_block.end(), c->m_layer[i].blocks.begin(),
+                      c->m_layer[i].blocks.end());
+  if (optimize)
+    c->optimize();
+
+  c->m_outputs = outputs;
+  c->m_history = history;
+  c->m_widest = widest;
+  c->m_context = c->make_context();
+  return c;
+}
+
+size_t compiled_net::layer_count() const { return m_layer.size(); }
+
+const compiled_net::layer_plan &compiled_net::get_layer(size_t index) const {
+  return m_layer[index];
+}
+
+size_t compiled_net::input_count() const { return m_layer.front().size; }
+
+size_t compiled_net::output_count() const { return m_layer.back().size; }
+
+size_t compiled_net::weight_count() const { return m_gene.size(); }
+
+bool compiled_net::feedforward() const { return m_feedforward; }
+
+bool compiled_net::all_direct() const { return m_all_direct; }
+
+compiled_net::context::ptr compiled_net::make_context() const {
+  context::ptr ctx(new context);
+  ctx->matrix = m_matrix;
+  ctx->block.resize(m_block.size());
+  for (size_t b = 0; b < m_block.size(); ++b)
+    ctx->block[b] = &ctx->matrix[m_block[b].offset];
+  ctx->state.assign(m_outputs + m_history, 0.0);
+  ctx->sum.assign(m_widest, 0.0);
+  ctx->previous.assign(m_widest, 0.0);
+  return ctx;
+}
+
+void compiled_net::set_weights(context &ctx,
+                               const std::vector<double> &weights) const {
+  set_weights_range(ctx, 0, weights.empty() ? 0 : &weights[0],
+                    weights.size());
+}
+
+std::vector<double> compiled_net::get_weights(const context &ctx) const {
+  if (ctx.bound)
+    return std::vector<double>(ctx.bound, ctx.bound + m_gene.size());
+  std::vector<double> weights(m_gene.size());
+  for (size_t i = 0; i < m_gene.size(); ++i)
+    weights[i] = ctx.matrix[m_gene[i]];
+  return weights;
+}
+
+size_t compiled_net::weights_into(const context &ctx, double *weights,
+                                  size_t size) const {
+  size_t count = std::min(size, m_gene.size());
+  for (size_t i = 0; i < count; ++i)
+    weights[i] = ctx.bound ? ctx.bound[i] : ctx.matrix[m_gene[i]];
+  return m_gene.size();
+}
+
+void compiled_net::set_weight(context &ctx, size_t index,
+                              double value) const {
+  set_weights_range(ctx, index, &value, 1);
+}
+
+void compiled_net::set_weights_range(context &ctx, size_t first,
+                                     const double *values,
+                                     size_t count) const {
+  unbind(ctx, first, count);
+  for (size_t i = 0; i < count && first + i < m_gene.size(); ++i)
+    ctx.matrix[m_gene[first + i]] = values[i];
+  if (!m_fusion.empty())
+    derive(&ctx.matrix[0], &ctx.block[0]);
+}
+
+void compiled_net::bind_weights(context &ctx, const double *weights) const {
+  ctx.bound = weights;
+  for (size_t i = 0; i < m_scatter.size(); ++i)
+    ctx.matrix[m_gene[m_scatter[i]]] = weights[m_scatter[i]];
+  for (size_t b = 0; b < m_block.size(); ++b)
+    ctx.block[b] = m_block[b].direct
+      ? weights + m_block[b].gene
+      : &ctx.matrix[m_block[b].offset];
+  if (!m_fusion.empty())
+    derive(&ctx.matrix[0], &ctx.block[0]);
+}
+
+bool compiled_net::bind_weights(context &ctx,
+                                const std::vector<double> &weights) const {
+  if (weights.size() != m_gene.size())
+    return false;
+  bind_weights(ctx, weights.empty() ? 0 : &weights[0]);
+  return true;
+}
+
+std::vector<double> compiled_net::compute(
+    context &ctx, const std::vector<double> &input) const {
+  load_input(ctx, input.empty() ? 0 : &input[0], input.size());
+  compute_step(ctx);
+
+  const layer_plan &out = m_layer.back();
+  return std::vector<double>(ctx.state.begin() + out.offset,
+                             ctx.state.begin() + out.offset + out.size);
+}
+
+size_t compiled_net::compute_into(context &ctx, const double *input,
+                                  size_t input_size, double *output,
+                                  size_t output_size) const {
+  load_input(ctx, input, input_size);
+  compute_step(ctx);
+
+  const layer_plan &out = m_layer.back();
+  const double *y = &ctx.state[out.offset];
+  std::copy(y, y + std::min(out.size, output_size), output);
+  return out.size;
+}
+
+void compiled_net::compute_batch(context &ctx,
+                                 const std::vector<double> &input,
+                                 std::vector<double> &output) const {
+  const layer_plan &in = m_layer.front();
+  const layer_plan &out = m_layer.back();
+  size_t rows = in.size ? input.size() / in.size : 0;
+  output.resize(rows * out.size);
+  if (rows == 0)
+    return;
+
+  if (!m_feedforward) {
+    for (size_t r = 0; r < rows; ++r) {
+      load_input(ctx, &input[r * in.size], in.size);
+      compute_step(ctx);
+      std::copy(ctx.state.begin() + out.offset,
+                ctx.state.begin() + out.offset + out.size,
+                output.begin() + r * out.size);
+    }
+    return;
+  }
+
+  // Layer l of sample r lives at batch[rows * l.offset + r * l.size].
+  if (ctx.batch.size() < rows * m_outputs)
+    ctx.batch.resize(rows * m_outputs);
+  double *x = &ctx.batch[rows * in.offset];
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t s = 0; s < in.spans.size(); ++s) {
+      const span &sp = in.spans[s];
+      if (sp.kind != input_activation)
+        continue;
+      for (size_t j = sp.first; j < sp.last; ++j)
+        x[r * in.size + j] = input[r * in.size + j];
+    }
+  }
+
+  for (size_t i = 0; i < m_layer.size(); ++i)
+    compute_layer_batch(ctx, i, rows);
+
+  const double *y = &ctx.batch[rows * out.offset];
+  std::copy(y, y + rows * out.size, output.begin());
+}
+
+void compiled_net::compute_population(context &ctx,
+                                      const std::vector<double> &weights,
+                                      const std::vector<double> &input,
+                                      std::vector<double> &output) const {
+  const layer_plan &in = m_layer.front();
+  const layer_plan &out = m_layer.back();
+  const size_t genes = m_gene.size();
+  const size_t genomes = genes ? weights.size() / genes : 0;
+  const size_t samples = in.size ? input.size() / in.size : 0;
+  output.resize(genomes * samples * out.size);
+  if (genomes == 0 || samples == 0)
+    return;
+
+  if (!m_feedforward) {
+    context::ptr scratch = make_context();
+    for (size_t g = 0; g < genomes; ++g) {
+      bind_weights(*scratch, &weights[g * genes]);
+      reset(*scratch);
+      for (size_t n = 0; n < samples; ++n) {
+        load_input(*scratch, &input[n * in.size], in.size);
+        compute_step(*scratch);
+        std::copy(scratch->state.begin() + out.offset,
+                  scratch->state.begin() + out.offset + out.size,
+                  output.begin() + (g * samples + n) * out.size);
+      }
+    }
+    return;
+  }
+
+  // Direct blocks are read from the genome rows in place; only the others
+  // get a per-genome copy with constant links keeping their compiled value,
+  // and fused blocks are derived from it.
+  const size_t matrix = m_matrix.size();
+  const size_t blocks = m_block.size();
+  if (!m_all_direct)
+    ctx.genome_matrix.resize(genomes * matrix);
+  ctx.genome_block.resize(genomes * blocks);
+  for (size_t g = 0; g < genomes; ++g) {
+    const double *genome = &weights[g * genes];
+    double *w = m_all_direct ? 0 : &ctx.genome_matrix[g * matrix];
+    const double **p = &ctx.genome_block[g * blocks];
+    if (w) {
+      std::copy(m_matrix.begin(), m_matrix.end(), w);
+      for (size_t i = 0; i < m_scatter.size(); ++i)
+        w[m_gene[m_scatter[i]]] = genome[m_scatter[i]];
+    }
+    for (size_t b = 0; b < blocks; ++b)
+      p[b] = m_block[b].direct ? genome + m_block[b].gene
+                               : w + m_block[b].offset;
+    if (w)
+      derive(w, p);
+  }
+
+  // Genomes and samples are processed in tiles small enough for the
+  // activations of a whole tile to stay in cache. Layers without computed
+  // neurons (the inputs) are shared by all genomes of a tile, so each input
+  // row is loaded once and reused by every genome.
+  const size_t genome_tile = 16;
+  const size_t sample_tile = 64;
+  std::vector<size_t> base(m_layer.size());
+  size_t activations = 0;
+  for (size_t i = 0; i < m_layer.size(); ++i) {
+    base[i] = activations;
+    activations += (m_layer[i].computed ? genome_tile : 1)
+      * sample_tile * m_layer[i].size;
+  }
+  if (ctx.batch.size() < activations)
+    ctx.batch.resize(activations);
+  if (ctx.sum.size() < sample_tile * m_widest)
+    ctx.sum.resize(sample_tile * m_widest);
+
+  for (size_t g0 = 0; g0 < genomes; g0 += genome_tile) {
+    const size_t gcount = std::min(genome_tile, genomes - g0);
+    for (size_t n0 = 0; n0 < samples; n0 += sample_tile) {
+      const size_t ncount = std::min(sample_tile, samples - n0);
+
+      const size_t copies = in.computed ? gcount : 1;
+      for (size_t g = 0; g < copies; ++g) {
+        double *x = &ctx.batch[base[0] + g * sample_tile * in.size];
+        for (size_t s = 0; s < in.spans.size(); ++s) {
+          const span &sp = in.spans[s];
+          if (sp.kind != input_activation)
+            continue;
+          for (size_t n = 0; n < ncount; ++n)
+            for (size_t j = sp.first; j < sp.last; ++j)
+              x[n * in.size + j] = input[(n0 + n) * in.size + j];
+        }
+      }
+
+      for (size_t i = 0; i < m_layer.size(); ++i) {
+        const layer_plan &l = m_layer[i];
+        if (!l.computed)
+          continue;
+        for (size_t g = 0; g < gcount; ++g) {
+          const double **p = &ctx.genome_block[(g0 + g) * blocks];
+          double *sum = &ctx.sum[0];
+          std::fill(sum, sum + ncount * l.size, 0.0);
+          for (size_t b = 0; b < l.blocks.size(); ++b) {
+            const block &bl = l.blocks[b];
+            const layer_plan &src = m_layer[bl.source];
+            const double *x = &ctx.batch[base[bl.source]];
+            if (src.computed)
+              x += g * sample_tile * src.size;
+            multiply(bl, p[bl.index], x, ncount, sum);
+          }
+          activate_rows(l, sum, ncount,
+                        &ctx.batch[base[i] + g * sample_tile * l.size]);
+        }
+      }
+
+      for (size_t g = 0; g < gcount; ++g) {
+        const double *y = &ctx.batch[base.back()];
+        if (out.computed)
+          y += g * sample_tile * out.size;
+        std::copy(y, y + ncount * out.size,
+                  output.begin() + ((g0 + g) * samples + n0) * out.size);
+      }
+    }
+  }
+}
+
+void compiled_net::reset(context &ctx) const {
+  std::fill(ctx.state.begin(), ctx.state.end(), 0.0);
+  ctx.step = 0;
+}
+
+void compiled_net::save_state(const context &ctx, snapshot &s) const {
+  s.state.resize(ctx.state.size());
+  std::copy(ctx.state.begin(), ctx.state.end(), s.state.begin());
+  s.step = ctx.step;
+}
+
+bool compiled_net::restore_state(context &ctx, const snapshot &s) const {
+  if (s.state.size() != ctx.state.size())
+    return false;
+  std::copy(s.state.begin(), s.state.end(), ctx.state.begin());
+  ctx.step = s.step;
+  return true;
+}
+
+void compiled_net::set_weights(const std::vector<double> &weights) {
+  set_weights(*m_context, weights);
+}
+
+std::vector<double> compiled_net::get_weights() const {
+  return get_weights(*m_context);
+}
+
+size_t compiled_net::weights_into(double *weights, size_t size) const {
+  return weights_into(*m_context, weights, size);
+}
+
+void compiled_net::set_weight(size_t index, double value) {
+  set_weight(*m_context, index, value);
+}
+
+void compiled_net::set_weights_range(size_t first, const double *values,
+                                     size_t count) {
+  set_weights_range(*m_context, first, values, count);
+}
+
+void compiled_net::bind_weights(const double *weights) {
+  bind_weights(*m_context, weights);
+}
+
+bool compiled_net::bind_weights(const std::vector<double> &weights) {
+  return bind_weights(*m_context, weights);
+}
+
+std::vector<double> compiled_net::compute(const std::vector<double> &input) {
+  return compute(*m_context, input);
+}
+
+size_t compiled_net::compute_into(const double *input, size_t input_size,
+                                  double *output, size_t output_size) {
+  return compute_into(*m_context, input, input_size, output, output_size);
+}
+
+void compiled_net::compute_batch(const std::vector<double> &input,
+                                 std::vector<double> &output) {
+  compute_batch(*m_context, input, output);
+}
+
+void compiled_net::compute_population(const std::vector<double> &weights,
+                                      const std::vector<double> &input,
+                                      std::vector<double> &output) {
+  compute_population(*m_context, weights, input, output);
+}
+
+void compiled_net::reset() { reset(*m_context); }
+
+void compiled_net::save_state(snapshot &s) const {
+  save_state(*m_context, s);
+}
+
+bool compiled_net::restore_state(const snapshot &s) {
+  return restore_state(*m_context, s);
+}
+
+const kernels &compiled_net::get_kernels() const { return *m_kernels; }
+
+void compiled_net::set_kernels(const kernels &k) { m_kernels = &k; }
+
+void compiled_net::unbind(context &ctx, size_t first, size_t count) const {
+  if (!ctx.bound)
+    return;
+  // Genes about to be overwritten are not read, so replacing the whole
+  // genome never touches a buffer that may be gone by now.
+  for (size_t i = 0; i < m_gene.size(); ++i)
+    if (i < first || i - first >= count)
+      ctx.matrix[m_gene[i]] = ctx.bound[i];
+  ctx.bound = 0;
+  for (size_t b = 0; b < m_block.size(); ++b)
+    ctx.block[b] = &ctx.matrix[m_block[b].offset];
+}
+
+void compiled_net::load_input(context &ctx, const double *input,
+                              size_t count) const {
+  const layer_plan &in = m_layer.front();
+  for (size_t s = 0; s < in.spans.size(); ++s) {
+    const span &sp = in.spans[s];
+    if (sp.kind != input_activation)
+      continue;
+    for (size_t j = sp.first; j < sp.last && j < count; ++j)
+      ctx.state[in.offset + j] = input[j];
+  }
+}
+
+void compiled_net::compute_step(context &ctx) const {
+  for (size_t i = 0; i < m_layer.size(); ++i)
+    compute_layer(ctx, i);
+  ++ctx.step;
+}
+
+void compiled_net::compute_layer(context &ctx, size_t index) const {
+  const layer_plan &l = m_layer[index];
+  if (!l.computed)
+    return;
+
+  double *out = &ctx.state[l.offset];
+  double *sum = &ctx.sum[0];
+  if (l.lateral)
+    std::copy(out, out + l.size, ctx.previous.begin());
+  std::fill(sum, sum + l.size, 0.0);
+
+  for (size_t b = 0; b < l.blocks.size(); ++b) {
+    const block &bl = l.blocks[b];
+    const double *x = bl.source == index
+      ? &ctx.previous[0]
+      : &ctx.state[m_layer[bl.source].offset];
+    multiply(bl, ctx.block[bl.index], x, sum);
+  }
+
+  for (size_t s = 0; s < l.spans.size(); ++s) {
+    const span &sp = l.spans[s];
+    size_t n = sp.last - sp.first;
+    if (sp.kind == softsign_activation)
+      m_kernels->softsign(sum + sp.first, n, out + sp.first);
+    else if (sp.kind == linear_activation)
+      m_kernels->linear(sum + sp.first, n, out + sp.first);
+  }
+
+  for (size_t d = 0; d < l.delays.size(); ++d) {
+    const delay_line &dl = l.delays[d];
+    double now = sum[dl.neuron];
+    if (dl.length == 0) {
+      out[dl.neuron] = now;
+    } else {
+      double *h = &ctx.state[m_outputs + dl.offset + ctx.step % dl.length];
+      out[dl.neuron] = *h;
+      *h = now;
+    }
+  }
+}
+
+void compiled_net::compute_layer_batch(context &ctx, size_t index,
+                                       size_t rows) const {
+  const layer_plan &l = m_layer[index];
+  if (!l.computed)
+    return;
+
+  double *out = &ctx.batch[rows * l.offset];
+  std::vector<double> &sum = ctx.sum;
+  if (sum.size() < rows * l.size)
+    sum.resize(rows * l.size);
+  std::fill(sum.begin(), sum.begin() + rows * l.size, 0.0);
+
+  for (size_t b = 0; b < l.blocks.size(); ++b) {
+    const block &bl = l.blocks[b];
+    multiply(bl, ctx.block[bl.index],
+             &ctx.batch[rows * m_layer[bl.source].offset], rows, &sum[0]);
+  }
+
+  activate_rows(l, &sum[0], rows, out);
+}
+
+void compiled_net::optimize() {
+  // A linear layer read by exactly one later layer, and fed only by earlier
+  // ones, is folded into its reader: W_ba * W_as replaces the reader's
+  // block from it. The products are recomputed by derive() whenever the
+  // weights change, so genomes keep the original layout.
+  for (size_t a = 1; a + 1 < m_layer.size(); ++a) {
+    layer_plan &la = m_layer[a];
+    bool linear = la.computed && !la.lateral && la.delays.empty();
+    for (size_t s = 0; s < la.spans.size(); ++s)
+      linear = linear && la.spans[s].kind == linear_activation;
+    for (size_t b = 0; b < la.blocks.size(); ++b)
+      linear = linear && la.blocks[b].source < a;
+    if (!linear)
+      continue;
+
+    size_t reader = m_layer.size();
+    size_t readers = 0;
+    for (size_t i = 0; i < m_layer.size(); ++i)
+      for (size_t b = 0; b < m_layer[i].blocks.size(); ++b)
+        if (m_layer[i].blocks[b].source == a) {
+          reader = i;
+          ++readers;
+        }
+    if (readers != 1 || reader <= a)
+      continue;
+
+    std::vector<block> &into = m_layer[reader].blocks;
+    size_t from_a = 0;
+    while (into[from_a].source != a)
+      ++from_a;
+    const block left = into[from_a];
+    into.erase(into.begin() + from_a);
+    for (size_t b = 0; b < la.blocks.size(); ++b) {
+      const block &right = la.blocks[b];
+      block d = { m_block.size(), right.source, left.rows, right.cols,
+                  m_matrix.size(), left.rows * right.cols, false, 0, false,
+                  false, 0 };
+      fusion f = { d.index, no_block, left.index, right.index };
+      size_t existing = 0;
+      while (existing < into.size() && into[existing].source != right.source)
+        ++existing;
+      if (existing < into.size()) {
+        f.base = into[existing].index;
+        into[existing] = d;
+      } else {
+        into.push_back(d);
+      }
+      m_matrix.resize(m_matrix.size() + d.entries, 0.0);
+      m_block.push_back(d);
+      m_fusion.push_back(f);
+    }
+    la.blocks.clear();
+    la.computed = false;
+    m_all_direct = false;
+  }
+
+  // Layers no output depends on, and blocks without links, are dropped.
+  std::vector<bool> live(m_layer.size(), false);
+  live.back() = true;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = 0; i < m_layer.size(); ++i) {
+      if (!live[i])
+        continue;
+      for (size_t b = 0; b < m_layer[i].blocks.size(); ++b) {
+        size_t source = m_layer[i].blocks[b].source;
+        if (!live[source])
+          changed = live[source] = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < m_layer.size(); ++i) {
+    std::vector<block> &blocks = m_layer[i].blocks;
+    if (!live[i]) {
+      blocks.clear();
+      m_layer[i].computed = false;
+      m_layer[i].lateral = false;
+    }
+    for (size_t b = 0; b < blocks.size();)
+      if (blocks[b].entries == 0)
+        blocks.erase(blocks.begin() + b);
+      else
+        ++b;
+  }
+
+  if (m_fusion.empty())
+    return;
+  std::vector<const double *> pointer(m_block.size());
+  for (size_t b = 0; b < m_block.size(); ++b)
+    pointer[b] = &m_matrix[m_block[b].offset];
+  derive(&m_matrix[0], &pointer[0]);
+}
+
+void compiled_net::derive(double *matrix, const double **pointer) const {
+  for (size_t f = 0; f < m_fusion.size(); ++f) {
+    const fusion &fu = m_fusion[f];
+    const block &d = m_block[fu.target];
+    double *out = matrix + d.offset;
+    std::fill(out, out + d.entries, 0.0);
+    if (fu.base != no_block)
+      add_product(m_block[fu.base], pointer[fu.base], 0, 0, out);
+    add_product(m_block[fu.left], pointer[fu.left], &m_block[fu.right],
+                pointer[fu.right], out);
+    pointer[fu.target] = out;
+  }
+}
+
+// out += left * right as a dense left.rows x right.cols matrix, or
+// out += left when there is no right factor.
+void compiled_net::add_product(const block &left, const double *lw,
+                               const block *right, const double *rw,
+                               double *out) const {
+  const size_t cols = right ? right->cols : left.cols;
+  for (size_t r = 0; r < left.rows; ++r) {
+    size_t first, last;
+    entry_range(left, r, first, last);
+    for (size_t e = first; e < last; ++e) {
+      size_t k = entry_column(left, r, e);
+      if (!right) {
+        out[r * cols + k] += lw[e];
+        continue;
+      }
+      size_t rfirst, rlast;
+      entry_range(*right, k, rfirst, rlast);
+      for (size_t re = rfirst; re < rlast; ++re)
+        out[r * cols + entry_column(*right, k, re)] += lw[e] * rw[re];
+    }
+  }
+}
+
+void compiled_net::entry_range(const block &bl, size_t row, size_t &first,
+                               size_t &last) const {
+  if (bl.sparse) {
+    first = m_pattern[bl.pattern + row];
+    last = m_pattern[bl.pattern + row + 1];
+  } else {
+    first = row * bl.cols;
+    last = first + bl.cols;
+  }
+}
+
+size_t compiled_net::entry_column(const block &bl, size_t row,
+                                  size_t entry) const {
+  if (bl.sparse)
+    return m_pattern[bl.pattern + bl.rows + 1 + entry];
+  return entry - row * bl.cols;
+}
+
+void compiled_net::multiply(const block &bl, const double *w,
+                            const double *x, double *y) const {
+  if (bl.copy) {
+    const size_t *row = &m_pattern[bl.pattern];
+    const size_t *col = row + bl.rows + 1;
+    for (size_t r = 0; r < bl.rows; ++r)
+      for (size_t k = row[r]; k < row[r + 1]; ++k)
+        y[r] += x[col[k]];
+  } else if (bl.sparse) {
+    const size_t *row = &m_pattern[bl.pattern];
+    m_kernels->spmv(w, row, row + bl.rows + 1, bl.rows, x, y);
+  } else {
+    m_kernels->gemv(w, bl.rows, bl.cols, x, y);
+  }
+}
+
+void compiled_net::multiply(const block &bl, const double *w,
+                            const double *x, size_t count, double *y) const {
+  if (bl.copy) {
+    for (size_t s = 0; s < count; ++s)
+      multiply(bl, w, x + s * bl.cols, y + s * bl.rows);
+  } else if (bl.sparse) {
+    const size_t *row = &m_pattern[bl.pattern];
+    m_kernels->spmm(w, row, row + bl.rows + 1, bl.rows, bl.cols, x, count,
+                    y);
+  } else {
+    m_kernels->gemm(w, bl.rows, bl.cols, x, count, y);
+  }
+}
+
+void compiled_net::activate_rows(const layer_plan &l, const double *sum,
+                                 size_t rows, double *out) const {
+  if (l.spans.size() == 1) {
+    const span &sp = l.spans[0];
+    if (sp.kind == softsign_activation)
+      m_kernels->softsign(sum, rows * l.size, out);
+    else if (sp.kind == linear_activation)
+      m_kernels->linear(sum, rows * l.size, out);
+    return;
+  }
+
+  for (size_t s = 0; s < l.spans.size(); ++s) {
+    const span &sp = l.spans[s];
+    size_t n = sp.last - sp.first;
+    for (size_t r = 0; r < rows; ++r) {
+      const double *z = sum + r * l.size + sp.first;
+      double *o = out + r * l.size + sp.first;
+      if (sp.kind == softsign_activation)
+        m_kernels->softsign(z, n, o);
+      else if (sp.kind == linear_activation)
+        m_kernels->linear(z, n, o);
+    }
+  }
+}
+}
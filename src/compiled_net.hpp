@@ -0,0 +1,291 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __COMPILED_NET_HPP
+#define __COMPILED_NET_HPP
+#include <cstdlib>
+
+#include <memory>
+#include <vector>
+
+namespace ga4nn {
+class gradient_net;
+class incremental_net;
+class neural_net;
+class tangent_net;
+struct kernels;
+
+// Flat inference plan produced by neural_net::compile(). Every layer is
+// lowered into dense weight blocks (one per source layer), activation spans
+// and a slot range in one contiguous output buffer, so compute() runs without
+// pointer chasing or virtual calls.
+class compiled_net {
+public:
+  typedef std::shared_ptr<compiled_net> ptr;
+
+  enum activation {
+    input_activation,
+    softsign_activation,
+    linear_activation,
+    feedback_activation
+  };
+
+  // Weights from the neurons of layer `source` into the neurons of the
+  // owning layer (rows = front neurons, cols = back neurons), stored as
+  // entries values from matrix[offset]. Dense blocks are row-major; sparse
+  // blocks keep only linked entries in CSR form, with row pointers and
+  // column indices at pattern[pattern ..]. A copy block only adds the
+  // linked inputs, its links all being constants of weight 1. A direct
+  // block holds no constants or gaps, so its values are exactly genes
+  // [gene, gene + entries) of the genome and can be read in place.
+  struct block {
+    size_t index;
+    size_t source;
+    size_t rows;
+    size_t cols;
+    size_t offset;
+    size_t entries;
+    bool sparse;
+    size_t pattern;
+    bool copy;
+    bool direct;
+    size_t gene;
+  };
+
+  // Neurons [first, last) of a layer sharing one activation.
+  struct span {
+    size_t first;
+    size_t last;
+    activation kind;
+  };
+
+  // Delay line of a feedback neuron: a ring of length slots starting at
+  // history[offset], read and overwritten at slot step % length.
+  struct delay_line {
+    size_t neuron;
+    size_t offset;
+    size_t length;
+  };
+
+  struct layer_plan {
+    size_t size;
+    size_t offset;
+    bool computed;
+    bool lateral;
+    std::vector<block> blocks;
+    std::vector<span> spans;
+    std::vector<delay_line> delays;
+  };
+
+  // Everything a single evaluation mutates: the weight binding, neuron
+  // outputs, feedback histories and scratch space. The plan itself is never
+  // written after compile(), so any number of threads may evaluate one
+  // compiled_net concurrently as long as each uses its own context.
+  class context {
+  public:
+    typedef std::shared_ptr<context> ptr;
+
+  private:
+    friend class compiled_net;
+    friend class incremental_net;
+    friend class tangent_net;
+    friend class gradient_net;
+    context() : bound(0), step(0) {}
+    context(const context &) = delete;
+    context &operator=(const context &) = delete;
+
+    std::vector<double> matrix;
+    std::vector<const double *> block;
+    const double *bound;
+
+    // Neuron outputs followed by all feedback histories, so the whole
+    // recurrent state is one contiguous block.
+    std::vector<double> state;
+    size_t step;
+
+    std::vector<double> sum;
+    std::vector<double> previous;
+    std::vector<double> batch;
+    std::vector<double> genome_matrix;
+    std::vector<const double *> genome_block;
+  };
+
+  // Copy of a context's recurrent state. Reusing one snapshot for repeated
+  // save_state() calls does not allocate.
+  class snapshot {
+  public:
+    snapshot() : step(0) {}
+
+  private:
+    friend class compiled_net;
+    std::vector<double> state;
+    size_t step;
+  };
+
+  // Blocks with fewer than sparse_density * rows * cols links are stored
+  // and evaluated as sparse matrices. With optimize, constant links are
+  // folded (weight 0 dropped, unit diagonals turned into copies), linear
+  // layers with a single reader are fused into it and layers no output
+  // depends on are skipped. The genome layout stays that of the net.
+  static ptr compile(const neural_net &net, double sparse_density = 0.25,
+                     bool optimize = false);
+
+  size_t layer_count() const;
+  const layer_plan &get_layer(size_t index) const;
+
+  size_t input_count() const;
+  size_t output_count() const;
+  size_t weight_count() const;
+  bool feedforward() const;
+  bool all_direct() const;
+
+  // A fresh context starts with the weights the net had when it was
+  // compiled and with cleared outputs and histories.
+  context::ptr make_context() const;
+
+  void set_weights(context &ctx, const std::vector<double> &weights) const;
+  std::vector<double> get_weights(const context &ctx) const;
+  size_t weights_into(const context &ctx, double *weights, size_t size) const;
+  // Changing part of a bound genome first copies the other genes into the
+  // context; the bound buffer itself is never written. Setting all genes
+  // does not read it.
+  void set_weight(context &ctx, size_t index, double value) const;
+  void set_weights_range(context &ctx, size_t first, const double *values,
+                         size_t count) const;
+
+  // Reads the weights straight from weights[0 .. weight_count()) instead
+  // of copying them: direct blocks just point into the buffer, so binding
+  // a new genome costs one pointer per block. The buffer must stay alive
+  // and unmoved until the next bind_weights() or until all genes are set.
+  void bind_weights(context &ctx, const double *weights) const;
+  // Returns false and keeps the previous weights for a genome whose size
+  // is not weight_count().
+  bool bind_weights(context &ctx, const std::vector<double> &weights) const;
+
+  std::vector<double> compute(context &ctx,
+                              const std::vector<double> &input) const;
+  // Writes at most output_size outputs and returns output_count(). Once
+  // the context exists this never allocates.
+  size_t compute_into(context &ctx, const double *input, size_t input_size,
+                      double *output, size_t output_size) const;
+  // Evaluates input.size() / input_count() samples stored row-major and
+  // writes them row-major into output. Feed-forward plans evaluate each
+  // layer for the whole batch at once; recurrent plans run the rows in
+  // order, exactly like repeated compute() calls.
+  void compute_batch(context &ctx, const std::vector<double> &input,
+                     std::vector<double> &output) const;
+  // Evaluates every genome of weights (row-major, genomes x
+  // weight_count()) on the same input rows; output is genomes x samples x
+  // output_count(). The context's weights and state are left untouched;
+  // recurrent plans start each genome from a cleared state.
+  void compute_population(context &ctx, const std::vector<double> &weights,
+                          const std::vector<double> &input,
+                          std::vector<double> &output) const;
+  void reset(context &ctx) const;
+  void save_state(const context &ctx, snapshot &s) const;
+  // Returns false and keeps the state for a snapshot of another net.
+  bool restore_state(context &ctx, const snapshot &s) const;
+
+  // The same operations on a context owned by the net. Convenient for a
+  // single thread, but not safe to call concurrently.
+  void set_weights(const std::vector<double> &weights);
+  std::vector<double> get_weights() const;
+  size_t weights_into(double *weights, size_t size) const;
+  void set_weight(size_t index, double value);
+  void set_weights_range(size_t first, const double *values, size_t count);
+  void bind_weights(const double *weights);
+  bool bind_weights(const std::vector<double> &weights);
+  std::vector<double> compute(const std::vector<double> &input);
+  size_t compute_into(const double *input, size_t input_size,
+                      double *output, size_t output_size);
+  void compute_batch(const std::vector<double> &input,
+                     std::vector<double> &output);
+  void compute_population(const std::vector<double> &weights,
+                          const std::vector<double> &input,
+                          std::vector<double> &output);
+  void reset();
+  void save_state(snapshot &s) const;
+  bool restore_state(const snapshot &s);
+
+  // Kernel table used by compute(); best_kernels() unless overridden.
+  const kernels &get_kernels() const;
+  void set_kernels(const kernels &k);
+
+private:
+  friend class incremental_net;
+  friend class tangent_net;
+  friend class gradient_net;
+
+  compiled_net();
+  compiled_net(const compiled_net &) = delete;
+  compiled_net &operator=(const compiled_net &) = delete;
+
+  // Copies the bound genome, except genes [first, first + count), into
+  // the context's matrix and points the blocks back at it.
+  void unbind(context &ctx, size_t first, size_t count) const;
+  void load_input(context &ctx, const double *input, size_t count) const;
+  void compute_step(context &ctx) const;
+  void compute_layer(context &ctx, size_t index) const;
+  void compute_layer_batch(context &ctx, size_t index, size_t rows) const;
+  // Block target = base + left * right, base being optional.
+  struct fusion {
+    size_t target;
+    size_t base;
+    size_t left;
+    size_t right;
+  };
+
+  void optimize();
+  void derive(double *matrix, const double **pointer) const;
+  void add_product(const block &left, const double *lw, const block *right,
+                   const double *rw, double *out) const;
+  void entry_range(const block &bl, size_t row, size_t &first,
+                   size_t &last) const;
+  size_t entry_column(const block &bl, size_t row, size_t entry) const;
+  void multiply(const block &bl, const double *w, const double *x,
+                double *y) const;
+  void multiply(const block &bl, const double *w, const double *x,
+                size_t count, double *y) const;
+  void activate_rows(const layer_plan &l, const double *sum, size_t rows,
+                     double *out) const;
+
+  std::vector<layer_plan> m_layer;
+  std::vector<double> m_matrix;
+  std::vector<size_t> m_gene;
+  std::vector<size_t> m_pattern;
+  std::vector<block> m_block;
+  std::vector<fusion> m_fusion;
+  std::vector<size_t> m_scatter;
+  size_t m_outputs;
+  size_t m_history;
+  size_t m_widest;
+  bool m_feedforward;
+  bool m_all_direct;
+  const kernels *m_kernels;
+
+  context::ptr m_context;
+};
+}
+
+#endif
@@ -24,30 +24,216 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #ifndef __CONNECTOR_HPP
 #define __CONNECTOR_HPP
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "neuron.hpp"
 
 namespace ga4nn {
-class internal_connector {
+// Every connector answers valid_connection() for a (back, front) pair.
+// The connectors below also describe their pattern row by row:
+// connection_count() is the total number of links and row() lists the
+// back neurons of one front neuron in ascending order. layer::connect_back()
+// uses that to build a layer in time proportional to the links created.
+class dense_connector {
 public:
+  explicit dense_connector(double weight = 0.0, bool constant = false) :
+    m_weight(weight), m_constant(constant) {}
+
   bool valid_connection(size_t back_index, size_t front_index) {
     return true;
   }
-  double weight() { return 0.0; }
-  bool constant() { return false; }
+  double weight() { return m_weight; }
+  bool constant() { return m_constant; }
+
+  size_t connection_count(size_t back_count, size_t front_count) {
+    return back_count * front_count;
+  }
+  void row(size_t front_index, size_t back_count, std::vector<size_t> &back) {
+    back.clear();
+    for (size_t j = 0; j < back_count; ++j)
+      back.push_back(j);
+  }
+
+private:
+  double m_weight;
+  bool m_constant;
+};
+
+class diagonal_connector {
+public:
+  explicit diagonal_connector(double weight = 0.0, bool constant = false) :
+    m_weight(weight), m_constant(constant) {}
+
+  bool valid_connection(size_t back_index, size_t front_index) {
+    return back_index == front_index;
+  }
+  double weight() { return m_weight; }
+  bool constant() { return m_constant; }
+
+  size_t connection_count(size_t back_count, size_t front_count) {
+    return std::min(back_count, front_count);
+  }
+  void row(size_t front_index, size_t back_count, std::vector<size_t> &back) {
+    back.clear();
+    if (front_index < back_count)
+      back.push_back(front_index);
+  }
+
+private:
+  double m_weight;
+  bool m_constant;
+};
+
+// Front neuron i is linked to back neurons i - below .. i + above.
+class banded_connector {
+public:
+  banded_connector(size_t below, size_t above, double weight = 0.0,
+                   bool constant = false) :
+    m_below(below), m_above(above), m_weight(weight), m_constant(constant) {}
+
+  bool valid_connection(size_t back_index, size_t front_index) {
+    return back_index + m_below >= front_index
+      && back_index <= front_index + m_above;
+  }
+  double weight() { return m_weight; }
+  bool constant() { return m_constant; }
+
+  size_t connection_count(size_t back_count, size_t front_count) {
+    size_t count = 0;
+    for (size_t i = 0; i < front_count; ++i) {
+      size_t first, last;
+      bounds(i, back_count, first, last);
+      count += last - first;
+    }
+    return count;
+  }
+  void row(size_t front_index, size_t back_count, std::vector<size_t> &back) {
+    size_t first, last;
+    bounds(front_index, back_count, first, last);
+    back.clear();
+    for (size_t j = first; j < last; ++j)
+      back.push_back(j);
+  }
+
+private:
+  void bounds(size_t front_index, size_t back_count, size_t &first,
+              size_t &last) const {
+    first = front_index > m_below ? front_index - m_below : 0;
+    last = std::min(back_count, front_index + m_above + 1);
+    if (first > last)
+      first = last;
+  }
+
+  size_t m_below;
+  size_t m_above;
+  double m_weight;
+  bool m_constant;
 };
 
-class feedback_connector {
+// Block-diagonal pattern: front neurons are grouped by front_block, back
+// neurons by back_block, and group k of the front is fully linked to group
+// k of the back.
+class block_connector {
 public:
+  block_connector(size_t back_block, size_t front_block, double weight = 0.0,
+                  bool constant = false) :
+    m_back_block(back_block), m_front_block(front_block), m_weight(weight),
+    m_constant(constant) {}
+
   bool valid_connection(size_t back_index, size_t front_index) {
-    if (back_index == front_index)
-      return true;
-    else
+    return m_back_block && m_front_block
+      && back_index / m_back_block == front_index / m_front_block;
+  }
+  double weight() { return m_weight; }
+  bool constant() { return m_constant; }
+
+  size_t connection_count(size_t back_count, size_t front_count) {
+    size_t count = 0;
+    for (size_t i = 0; i < front_count; ++i) {
+      size_t first, last;
+      bounds(i, back_count, first, last);
+      count += last - first;
+    }
+    return count;
+  }
+  void row(size_t front_index, size_t back_count, std::vector<size_t> &back) {
+    size_t first, last;
+    bounds(front_index, back_count, first, last);
+    back.clear();
+    for (size_t j = first; j < last; ++j)
+      back.push_back(j);
+  }
+
+private:
+  void bounds(size_t front_index, size_t back_count, size_t &first,
+              size_t &last) const {
+    first = last = 0;
+    if (!m_back_block || !m_front_block)
+      return;
+    size_t k = front_index / m_front_block;
+    first = std::min(back_count, k * m_back_block);
+    last = std::min(back_count, first + m_back_block);
+  }
+
+  size_t m_back_block;
+  size_t m_front_block;
+  double m_weight;
+  bool m_constant;
+};
+
+// Explicit pattern in compressed sparse row form: front neuron i is linked
+// to back neurons index[offset[i] .. offset[i + 1]), which must be sorted.
+class csr_connector {
+public:
+  csr_connector(const std::vector<size_t> &offset,
+                const std::vector<size_t> &index, double weight = 0.0,
+                bool constant = false) :
+    m_offset(offset), m_index(index), m_weight(weight), m_constant(constant) {}
+
+  bool valid_connection(size_t back_index, size_t front_index) {
+    if (front_index + 1 >= m_offset.size())
       return false;
+    return std::binary_search(m_index.begin() + m_offset[front_index],
+                              m_index.begin() + m_offset[front_index + 1],
+                              back_index);
+  }
+  double weight() { return m_weight; }
+  bool constant() { return m_constant; }
+
+  size_t connection_count(size_t back_count, size_t front_count) {
+    size_t count = 0;
+    for (size_t i = 0; i < front_count && i + 1 < m_offset.size(); ++i)
+      for (size_t k = m_offset[i]; k < m_offset[i + 1]; ++k)
+        if (m_index[k] < back_count)
+          ++count;
+    return count;
+  }
+  void row(size_t front_index, size_t back_count, std::vector<size_t> &back) {
+    back.clear();
+    if (front_index + 1 >= m_offset.size())
+      return;
+    for (size_t k = m_offset[front_index]; k < m_offset[front_index + 1]; ++k)
+      if (m_index[k] < back_count)
+        back.push_back(m_index[k]);
   }
-  double weight() { return 1.0; }
-  bool constant() { return true; }
+
+private:
+  std::vector<size_t> m_offset;
+  std::vector<size_t> m_index;
+  double m_weight;
+  bool m_constant;
+};
+
+class internal_connector : public dense_connector {
+public:
+  internal_connector() : dense_connector(0.0, false) {}
+};
+
+class feedback_connector : public diagonal_connector {
+public:
+  feedback_connector() : diagonal_connector(1.0, true) {}
 };
 }
 
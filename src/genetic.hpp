@@ -35,8 +35,88 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "crossover.hpp"
 #include "mutation.hpp"
 #include "stop_function.hpp"
+#include "thread_pool.hpp"
 
 namespace ga4nn {
+  // One generation: selects parents from parent_population until it is
+  // empty and inserts their mutated children into child_population.
+  template< class Population,
+            class Selection,
+            class Crossover,
+            class Mutation>
+  void breed(typename Population::ptr parent_population,
+             typename Population::ptr child_population,
+             typename Selection::ptr selection,
+             typename Crossover::ptr crossover,
+             typename Mutation::ptr mutation) {
+    while (parent_population->count() > 0) {
+      std::vector<typename Population::genotype::ptr> parents =
+        selection->get_parents(parent_population);
+      std::vector<typename Population::genotype::ptr> children =
+        crossover->cross(parents);
+      for (size_t i = 0; i < children.size(); i++) {
+        child_population->insert(mutation->mutate(children[i]));
+      }
+    }
+  }
+
+  // Lets a population that keeps per-generation storage, such as
+  // arena_population, hand its children's storage to the parents.
+  template<class Population>
+  auto begin_generation(Population &p, int)
+    -> decltype(p.begin_generation(), void()) {
+    p.begin_generation();
+  }
+
+  template<class Population>
+  void begin_generation(Population &, long) {}
+
+  // Populations with a swap() member trade genotypes with the spare
+  // parents; any other population is copied.
+  template<class Population>
+  auto swap_generations(typename Population::ptr &parent_population,
+                        Population &population, int)
+    -> decltype(parent_population->swap(population), void()) {
+    if (!parent_population)
+      parent_population.reset(new Population(population));
+    else
+      parent_population->swap(population);
+  }
+
+  template<class Population>
+  void swap_generations(typename Population::ptr &parent_population,
+                        Population &population, long) {
+    parent_population.reset(new Population(population));
+  }
+
+  // Moves the genotypes of population into parent_population. With a
+  // swap() member that is a copy on the first call and a swap afterwards,
+  // so a run copies the population only when it starts rather than every
+  // generation. population is left empty to take the new children.
+  template<class Population>
+  void next_generation(typename Population::ptr &parent_population,
+                       Population &population) {
+    swap_generations(parent_population, population, 0);
+    population.clear();
+    begin_generation(*parent_population, 0);
+  }
+
+  // One generation of evolve() and of the island runners: the genotypes
+  // of population become the parents and their children replace them.
+  template< class Population,
+            class Selection,
+            class Crossover,
+            class Mutation>
+  void advance_generation(typename Population::ptr &parent_population,
+                          typename Population::ptr population,
+                          typename Selection::ptr selection,
+                          typename Crossover::ptr crossover,
+                          typename Mutation::ptr mutation) {
+    next_generation<Population>(parent_population, *population);
+    breed<Population, Selection, Crossover, Mutation>(
+      parent_population, population, selection, crossover, mutation);
+  }
+
   template< class Population,
             class Selection,
             class Crossover,
@@ -48,18 +128,73 @@ namespace ga4nn {
                     typename Mutation::ptr mutation,
                     typename StopFunction::ptr stop) {
     typename Population::ptr child_population(new Population(*initial_population));
+    typename Population::ptr parent_population;
     while (!stop->done(child_population)) {
-      typename Population::ptr parent_population(new Population(*child_population));
-      child_population->clear();
+      advance_generation<Population, Selection, Crossover, Mutation>(
+        parent_population, child_population, selection, crossover, mutation);
+    }
+    return child_population;
+  }
+
+  // Breeds a whole generation as evolve() above does, scores the children
+  // on pool and then inserts them in breeding order, so the populations
+  // are exactly those of the serial run. Genotype::fitness() must be safe
+  // to call on different genotypes at once. With concurrent_operators the
+  // parents are still selected in order, but crossover and mutation of
+  // each parent set run as pool tasks as well, and may spawn tasks of
+  // their own on the same pool; this needs operators whose result depends
+  // only on their arguments.
+  template< class Population,
+            class Selection,
+            class Crossover,
+            class Mutation,
+            class StopFunction>
+  typename Population::ptr evolve(typename Population::ptr initial_population,
+                    typename Selection::ptr selection,
+                    typename Crossover::ptr crossover,
+                    typename Mutation::ptr mutation,
+                    typename StopFunction::ptr stop,
+                    thread_pool::ptr pool,
+                    bool concurrent_operators = false) {
+    typedef typename Population::genotype genotype;
+    typedef std::vector<typename genotype::ptr> genotypes;
+    typename Population::ptr child_population(new Population(*initial_population));
+    typename Population::ptr parent_population;
+    std::vector<genotypes> parents, children;
+    genotypes brood;
+    while (!stop->done(child_population)) {
+      next_generation<Population>(parent_population, *child_population);
+      parents.clear();
+      brood.clear();
       while (parent_population->count() > 0) {
-        std::vector<typename Population::genotype::ptr> parents =
-          selection->get_parents(parent_population);
-        std::vector<typename Population::genotype::ptr> children =
-          crossover->cross(parents);
-        for (size_t i = 0; i < children.size(); i++) {
-          child_population->insert(mutation->mutate(children[i]));
+        parents.push_back(selection->get_parents(parent_population));
+        if (!concurrent_operators) {
+          genotypes c = crossover->cross(parents.back());
+          for (size_t i = 0; i < c.size(); i++) {
+            brood.push_back(mutation->mutate(c[i]));
+          }
         }
       }
+
+      if (concurrent_operators) {
+        children.assign(parents.size(), genotypes());
+        pool->run(parents.size(), [&](size_t k) {
+          children[k] = crossover->cross(parents[k]);
+          for (size_t i = 0; i < children[k].size(); i++) {
+            children[k][i] = mutation->mutate(children[k][i]);
+            children[k][i]->fitness();
+          }
+        });
+        for (size_t k = 0; k < children.size(); k++) {
+          brood.insert(brood.end(), children[k].begin(), children[k].end());
+        }
+      } else {
+        evaluate_fitness<genotype>(pool, brood);
+      }
+
+      for (size_t i = 0; i < brood.size(); i++) {
+        child_population->insert(brood[i]);
+      }
     }
     return child_population;
   }
@@ -0,0 +1,169 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "genome_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace ga4nn {
+namespace {
+const size_t row_alignment = 64;
+const size_t row_doubles = row_alignment / sizeof(double);
+
+struct generation {
+  std::vector<double> storage;
+  size_t offset;
+  std::vector<double> fitness;
+  std::vector<unsigned char> flags;
+  size_t count;
+  // Bumped whenever the rows are emptied for reuse.
+  size_t epoch;
+
+  generation() : offset(0), count(0), epoch(0) {}
+
+  double *rows() { return &storage[offset]; }
+
+  // Room for capacity rows of stride doubles, keeping the rows there are.
+  void reserve(size_t capacity, size_t stride) {
+    std::vector<double> grown(capacity * stride + row_doubles, 0.0);
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(&grown[0]);
+    size_t aligned = (row_alignment - p % row_alignment) % row_alignment
+      / sizeof(double);
+    if (count > 0)
+      std::copy(rows(), rows() + count * stride, &grown[aligned]);
+    storage.swap(grown);
+    offset = aligned;
+    fitness.resize(capacity, 0.0);
+    flags.resize(capacity, 0);
+  }
+};
+}
+
+struct genome_arena::prv {
+  size_t genes;
+  size_t stride;
+  size_t parents;
+  generation generations[2];
+};
+
+genome_arena::genome_arena() : d(new prv) {}
+genome_arena::~genome_arena() {}
+
+genome_arena::ptr genome_arena::create(size_t capacity, size_t genes) {
+  if (capacity == 0 || genes == 0)
+    return ptr();
+  size_t stride = (genes + row_doubles - 1) / row_doubles * row_doubles;
+  if (stride < genes || capacity > (size_t(-1) / 2 - row_doubles) / stride)
+    return ptr();
+  ptr a(new genome_arena);
+  a->d->genes = genes;
+  a->d->stride = stride;
+  a->d->parents = 0;
+  a->d->generations[0].reserve(capacity, stride);
+  a->d->generations[1].reserve(capacity, stride);
+  return a;
+}
+
+size_t genome_arena::genes() const { return d->genes; }
+
+size_t genome_arena::stride() const { return d->stride; }
+
+size_t genome_arena::parents() const { return d->parents; }
+
+size_t genome_arena::count(size_t generation) const {
+  return d->generations[generation].count;
+}
+
+size_t genome_arena::capacity(size_t generation) const {
+  return d->generations[generation].fitness.size();
+}
+
+genome_arena::slot genome_arena::add_child() {
+  slot s = {1 - d->parents, 0, d->generations[1 - d->parents].epoch};
+  generation &g = d->generations[s.generation];
+  if (g.count == g.fitness.size())
+    g.reserve(2 * g.count, d->stride);
+  s.index = g.count++;
+  std::fill(g.rows() + s.index * d->stride,
+            g.rows() + (s.index + 1) * d->stride, 0.0);
+  g.fitness[s.index] = 0.0;
+  g.flags[s.index] = 0;
+  return s;
+}
+
+bool genome_arena::valid(const slot &s) const {
+  return s.generation < 2 && s.epoch == d->generations[s.generation].epoch
+    && s.index < d->generations[s.generation].count;
+}
+
+double *genome_arena::genome(const slot &s) {
+  assert(valid(s));
+  return d->generations[s.generation].rows() + s.index * d->stride;
+}
+
+const double *genome_arena::genome(const slot &s) const {
+  assert(valid(s));
+  return d->generations[s.generation].rows() + s.index * d->stride;
+}
+
+double genome_arena::fitness(const slot &s) const {
+  assert(valid(s));
+  return d->generations[s.generation].fitness[s.index];
+}
+
+unsigned genome_arena::flags(const slot &s) const {
+  assert(valid(s));
+  return d->generations[s.generation].flags[s.index];
+}
+
+void genome_arena::set_fitness(const slot &s, double fitness) {
+  assert(valid(s));
+  generation &g = d->generations[s.generation];
+  g.fitness[s.index] = fitness;
+  g.flags[s.index] |= scored;
+}
+
+void genome_arena::set_flags(const slot &s, unsigned flags) {
+  assert(valid(s));
+  d->generations[s.generation].flags[s.index] =
+    static_cast<unsigned char>(flags);
+}
+
+void genome_arena::swap() {
+  d->parents = 1 - d->parents;
+  generation &children = d->generations[1 - d->parents];
+  children.count = 0;
+  ++children.epoch;
+}
+
+void genome_arena::clear() {
+  for (size_t g = 0; g < 2; ++g) {
+    d->generations[g].count = 0;
+    ++d->generations[g].epoch;
+  }
+}
+}
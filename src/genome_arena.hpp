@@ -0,0 +1,101 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __GENOME_ARENA_HPP
+#define __GENOME_ARENA_HPP
+#include <cstdlib>
+
+#include <memory>
+
+namespace ga4nn {
+// Genomes of a parent and a child generation stored as structures of
+// arrays: per generation one rows x genes matrix, each row aligned to 64
+// bytes, with parallel fitness and flag arrays. Children are appended to
+// the child generation and swap() makes them the parents by exchanging
+// the roles of the two generations, so once both have grown to the
+// population size a run allocates nothing more. Not thread-safe, except
+// that different rows may be read and written at once.
+class genome_arena {
+public:
+  typedef typename std::shared_ptr<genome_arena> ptr;
+
+  enum flag {
+    scored = 1
+  };
+
+  // A row of one of the two generations. It stays valid until that
+  // generation takes children again, after the second swap() from now;
+  // epoch tells the rows of successive uses of a generation apart.
+  struct slot {
+    size_t generation;
+    size_t index;
+    size_t epoch;
+  };
+
+  // Both generations start with room for capacity rows. Returns an empty
+  // ptr for zero capacity or genes.
+  static ptr create(size_t capacity, size_t genes);
+  ~genome_arena();
+
+  size_t genes() const;
+  // Doubles from one row to the next.
+  size_t stride() const;
+
+  // The generation holding the parents; children go into the other one.
+  size_t parents() const;
+  size_t count(size_t generation) const;
+  size_t capacity(size_t generation) const;
+
+  // Appends a zeroed, unscored row to the children. A full generation
+  // doubles its capacity, which moves its rows: pointers returned by
+  // genome() are only good until the next add_child().
+  slot add_child();
+  // False once the slot's row has been handed to a later generation. The
+  // accessors below assert this in debug builds.
+  bool valid(const slot &s) const;
+
+  double *genome(const slot &s);
+  const double *genome(const slot &s) const;
+  double fitness(const slot &s) const;
+  unsigned flags(const slot &s) const;
+  // Also sets the scored flag.
+  void set_fitness(const slot &s, double fitness);
+  void set_flags(const slot &s, unsigned flags);
+
+  // The children become the parents, and the rows of the former parents
+  // are reused for the next children.
+  void swap();
+  void clear();
+
+private:
+  genome_arena();
+  genome_arena(const genome_arena &) = delete;
+  genome_arena &operator=(const genome_arena &) = delete;
+
+  struct prv;
+  std::shared_ptr<prv> d;
+};
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "genome_codec.hpp"
+
+#include <cstring>
+
+#include <stdint.h>
+
+namespace ga4nn {
+namespace {
+const uint32_t magic = 0x4e4e3447;  // "G4NN"
+const uint32_t version = 1;
+const size_t header_size = 16;
+
+void put32(uint32_t v, unsigned char *out) {
+  for (size_t i = 0; i < 4; ++i)
+    out[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+uint32_t get32(const unsigned char *in) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < 4; ++i)
+    v |= static_cast<uint32_t>(in[i]) << (8 * i);
+  return v;
+}
+
+void put_double(double d, unsigned char *out) {
+  uint64_t v;
+  std::memcpy(&v, &d, sizeof(v));
+  for (size_t i = 0; i < 8; ++i)
+    out[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+double get_double(const unsigned char *in) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; ++i)
+    v |= static_cast<uint64_t>(in[i]) << (8 * i);
+  double d;
+  std::memcpy(&d, &v, sizeof(d));
+  return d;
+}
+}
+
+void encode_genomes(const std::vector<double> &genes, size_t genome_size,
+                    const std::vector<double> &fitness,
+                    std::vector<unsigned char> &block) {
+  const size_t count = fitness.size();
+  block.resize(header_size + count * (genome_size + 1) * 8);
+  unsigned char *out = &block[0];
+  put32(magic, out);
+  put32(version, out + 4);
+  put32(static_cast<uint32_t>(count), out + 8);
+  put32(static_cast<uint32_t>(genome_size), out + 12);
+  out += header_size;
+  for (size_t g = 0; g < count; ++g) {
+    put_double(fitness[g], out);
+    out += 8;
+    for (size_t i = 0; i < genome_size; ++i, out += 8)
+      put_double(g * genome_size + i < genes.size()
+                 ? genes[g * genome_size + i] : 0.0, out);
+  }
+}
+
+bool decode_genomes(const unsigned char *block, size_t size,
+                    std::vector<double> &genes, size_t &genome_size,
+                    std::vector<double> &fitness) {
+  genes.clear();
+  fitness.clear();
+  genome_size = 0;
+  if (size < header_size || get32(block) != magic
+      || get32(block + 4) != version)
+    return false;
+  const size_t count = get32(block + 8);
+  const size_t width = get32(block + 12);
+  if ((size - header_size) / 8 / (width + 1) < count
+      || size != header_size + count * (width + 1) * 8)
+    return false;
+
+  genome_size = width;
+  genes.resize(count * width);
+  fitness.resize(count);
+  const unsigned char *in = block + header_size;
+  for (size_t g = 0; g < count; ++g) {
+    fitness[g] = get_double(in);
+    in += 8;
+    for (size_t i = 0; i < width; ++i, in += 8)
+      genes[g * width + i] = get_double(in);
+  }
+  return true;
+}
+}
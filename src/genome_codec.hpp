@@ -0,0 +1,48 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __GENOME_CODEC_HPP
+#define __GENOME_CODEC_HPP
+#include <cstdlib>
+
+#include <vector>
+
+namespace ga4nn {
+// Binary block of genomes for migration between processes: a 16 byte
+// header (magic "G4NN", version, genome count, genes per genome) followed
+// by, per genome, its fitness and its genes. Integers and doubles are
+// written little-endian whatever the host, so blocks can cross machines.
+// genes holds count x genome_size values row-major, the layout
+// compiled_net::compute_population() takes.
+void encode_genomes(const std::vector<double> &genes, size_t genome_size,
+                    const std::vector<double> &fitness,
+                    std::vector<unsigned char> &block);
+
+// Returns false, leaving the outputs empty, for a malformed block.
+bool decode_genomes(const unsigned char *block, size_t size,
+                    std::vector<double> &genes, size_t &genome_size,
+                    std::vector<double> &fitness);
+}
+
+#endif
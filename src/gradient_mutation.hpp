@@ -0,0 +1,92 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __GRADIENT_MUTATION_HPP
+#define __GRADIENT_MUTATION_HPP
+#include <cstdlib>
+
+#include <vector>
+
+#include "gradient_net.hpp"
+#include "mutation.hpp"
+
+namespace ga4nn {
+// Lamarckian refinement: every child takes a few gradient steps on the
+// squared error of the net over a fixed data set before it is inserted,
+// and keeps the improved weights. A step that does not lower the error is
+// dropped and the rate halved, so refinement never makes a child worse.
+// Genotype must hold the genome as a std::vector<double> in get_data(),
+// and its fitness must not have been cached before mutate().
+template<class Genotype>
+class gradient_mutation : public mutation<Genotype> {
+public:
+  typedef Genotype genotype;
+  typedef typename std::shared_ptr<gradient_mutation<genotype> > ptr;
+
+  gradient_mutation(const gradient_net::ptr &net,
+                    const std::vector<double> &input,
+                    const std::vector<double> &target,
+                    size_t steps, double rate) :
+    m_net(net),
+    m_input(input),
+    m_target(target),
+    m_steps(steps),
+    m_rate(rate) {}
+
+  virtual typename genotype::ptr mutate(typename genotype::ptr g) {
+    std::vector<double> &weights = g->get_data();
+    double loss = m_net->loss_gradient(weights, m_input, m_target,
+                                       m_gradient);
+    double rate = m_rate;
+    for (size_t s = 0; s < m_steps; ++s) {
+      m_candidate.resize(weights.size());
+      for (size_t i = 0; i < weights.size(); ++i)
+        m_candidate[i] = weights[i] - rate * m_gradient[i];
+      double next = m_net->loss_gradient(m_candidate, m_input, m_target,
+                                         m_next);
+      if (next < loss) {
+        weights.swap(m_candidate);
+        m_gradient.swap(m_next);
+        loss = next;
+      } else {
+        rate /= 2;
+      }
+    }
+    return g;
+  }
+
+private:
+  gradient_net::ptr m_net;
+  std::vector<double> m_input;
+  std::vector<double> m_target;
+  size_t m_steps;
+  double m_rate;
+
+  std::vector<double> m_gradient;
+  std::vector<double> m_next;
+  std::vector<double> m_candidate;
+};
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "gradient_net.hpp"
+
+#include <algorithm>
+
+namespace ga4nn {
+namespace {
+const size_t no_block = static_cast<size_t>(-1);
+}
+
+gradient_net::gradient_net() : m_steps(0) {}
+
+gradient_net::ptr gradient_net::create(const compiled_net::ptr &net) {
+  if (!net)
+    return ptr();
+
+  ptr g(new gradient_net());
+  g->m_net = net;
+  g->m_context = net->make_context();
+  return g;
+}
+
+void gradient_net::forward(const std::vector<double> &weights,
+                           const std::vector<double> &input,
+                           std::vector<double> &output) {
+  const compiled_net &net = *m_net;
+  compiled_net::context &ctx = *m_context;
+  const compiled_net::layer_plan &in = net.m_layer.front();
+  const compiled_net::layer_plan &out = net.m_layer.back();
+  const size_t width = net.m_outputs;
+
+  net.set_weights(ctx, weights);
+  net.reset(ctx);
+  m_steps = in.size ? input.size() / in.size : 0;
+  m_value.resize(m_steps * width);
+  m_sum.assign(m_steps * width, 0.0);
+  output.resize(m_steps * out.size);
+
+  for (size_t t = 0; t < m_steps; ++t) {
+    net.load_input(ctx, &input[t * in.size], in.size);
+    for (size_t i = 0; i < net.m_layer.size(); ++i) {
+      const compiled_net::layer_plan &l = net.m_layer[i];
+      if (!l.computed)
+        continue;
+      net.compute_layer(ctx, i);
+      std::copy(ctx.sum.begin(), ctx.sum.begin() + l.size,
+                m_sum.begin() + t * width + l.offset);
+    }
+    ++ctx.step;
+    std::copy(ctx.state.begin(), ctx.state.begin() + width,
+              m_value.begin() + t * width);
+    std::copy(ctx.state.begin() + out.offset,
+              ctx.state.begin() + out.offset + out.size,
+              output.begin() + t * out.size);
+  }
+}
+
+// A block reads its source's outputs of the same step when the source is
+// evaluated before it, and those of the previous step otherwise (lateral
+// links and links from later layers), so adjoints flow back into the
+// current step or are carried into the previous one. A delay line of
+// length n hands the sum of step t to the output of step t + n.
+void gradient_net::backward(const std::vector<double> &output_gradient,
+                            std::vector<double> &gradient) {
+  const compiled_net &net = *m_net;
+  const compiled_net::context &ctx = *m_context;
+  const compiled_net::layer_plan &out = net.m_layer.back();
+  const size_t width = net.m_outputs;
+
+  m_adjoint.assign(width, 0.0);
+  m_carry.assign(width, 0.0);
+  m_delayed.assign(m_steps * width, 0.0);
+  m_matrix.assign(net.m_matrix.size(), 0.0);
+  m_scratch.resize(net.m_widest);
+
+  for (size_t t = m_steps; t-- > 0;) {
+    m_adjoint.swap(m_carry);
+    std::fill(m_carry.begin(), m_carry.end(), 0.0);
+    for (size_t o = 0; o < out.size; ++o)
+      m_adjoint[out.offset + o] += output_gradient[t * out.size + o];
+
+    for (size_t i = net.m_layer.size(); i-- > 0;) {
+      const compiled_net::layer_plan &l = net.m_layer[i];
+      if (!l.computed)
+        continue;
+
+      const double *gy = &m_adjoint[l.offset];
+      const double *z = &m_sum[t * width + l.offset];
+      double *gz = &m_scratch[0];
+      std::fill(gz, gz + l.size, 0.0);
+      for (size_t s = 0; s < l.spans.size(); ++s) {
+        const compiled_net::span &sp = l.spans[s];
+        for (size_t j = sp.first; j < sp.last; ++j) {
+          if (sp.kind == compiled_net::softsign_activation) {
+            double a = 1 + (z[j] < 0 ? -z[j] : z[j]);
+            gz[j] = gy[j] / (a * a);
+          } else if (sp.kind == compiled_net::linear_activation) {
+            gz[j] = gy[j];
+          }
+        }
+      }
+      for (size_t k = 0; k < l.delays.size(); ++k) {
+        const compiled_net::delay_line &dl = l.delays[k];
+        const size_t at = l.offset + dl.neuron;
+        if (dl.length == 0) {
+          gz[dl.neuron] = gy[dl.neuron];
+        } else {
+          gz[dl.neuron] = m_delayed[t * width + at];
+          if (t >= dl.length)
+            m_delayed[(t - dl.length) * width + at] += gy[dl.neuron];
+        }
+      }
+
+      for (size_t b = 0; b < l.blocks.size(); ++b) {
+        const compiled_net::block &bl = l.blocks[b];
+        const size_t offset = net.m_layer[bl.source].offset;
+        const bool current = bl.source < i;
+        const double *x = current
+          ? &m_value[t * width + offset]
+          : t > 0 ? &m_value[(t - 1) * width + offset] : 0;
+        double *gx = current ? &m_adjoint[offset] : &m_carry[offset];
+        const double *w = ctx.block[bl.index];
+        double *gw = &m_matrix[bl.offset];
+        for (size_t r = 0; r < bl.rows; ++r) {
+          if (gz[r] == 0.0)
+            continue;
+          size_t first, last;
+          net.entry_range(bl, r, first, last);
+          for (size_t e = first; e < last; ++e) {
+            size_t c = net.entry_column(bl, r, e);
+            if (x)
+              gw[e] += gz[r] * x[c];
+            gx[c] += (bl.copy ? 1.0 : w[e]) * gz[r];
+          }
+        }
+      }
+    }
+  }
+
+  backward_fusions();
+  gradient.resize(net.m_gene.size());
+  for (size_t g = 0; g < net.m_gene.size(); ++g)
+    gradient[g] = m_matrix[net.m_gene[g]];
+}
+
+// Undoes derive(): a fused block is base + left * right, so its adjoint
+// flows into base as it is and into left and right through the product.
+// Fusions are walked backwards, since later ones may read earlier targets.
+void gradient_net::backward_fusions() {
+  const compiled_net &net = *m_net;
+  const compiled_net::context &ctx = *m_context;
+  for (size_t f = net.m_fusion.size(); f-- > 0;) {
+    const compiled_net::fusion &fu = net.m_fusion[f];
+    const compiled_net::block &left = net.m_block[fu.left];
+    const compiled_net::block &right = net.m_block[fu.right];
+    const double *gt = &m_matrix[net.m_block[fu.target].offset];
+    const size_t cols = right.cols;
+
+    if (fu.base != no_block) {
+      const compiled_net::block &base = net.m_block[fu.base];
+      for (size_t r = 0; r < base.rows; ++r) {
+        size_t first, last;
+        net.entry_range(base, r, first, last);
+        for (size_t e = first; e < last; ++e)
+          m_matrix[base.offset + e] +=
+            gt[r * cols + net.entry_column(base, r, e)];
+      }
+    }
+
+    const double *lw = ctx.block[fu.left];
+    const double *rw = ctx.block[fu.right];
+    for (size_t r = 0; r < left.rows; ++r) {
+      size_t first, last;
+      net.entry_range(left, r, first, last);
+      for (size_t e = first; e < last; ++e) {
+        size_t k = net.entry_column(left, r, e);
+        size_t rfirst, rlast;
+        net.entry_range(right, k, rfirst, rlast);
+        for (size_t re = rfirst; re < rlast; ++re) {
+          double g = gt[r * cols + net.entry_column(right, k, re)];
+          m_matrix[left.offset + e] += g * rw[re];
+          m_matrix[right.offset + re] += lw[e] * g;
+        }
+      }
+    }
+  }
+}
+
+double gradient_net::loss_gradient(const std::vector<double> &weights,
+                                   const std::vector<double> &input,
+                                   const std::vector<double> &target,
+                                   std::vector<double> &gradient) {
+  forward(weights, input, m_output);
+  double loss = 0.0;
+  for (size_t i = 0; i < m_output.size(); ++i) {
+    double error = i < target.size() ? m_output[i] - target[i] : 0.0;
+    loss += error * error;
+    m_output[i] = 2 * error;
+  }
+  backward(m_output, gradient);
+  return loss;
+}
+}
@@ -0,0 +1,88 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __GRADIENT_NET_HPP
+#define __GRADIENT_NET_HPP
+#include <memory>
+#include <vector>
+
+#include "compiled_net.hpp"
+
+namespace ga4nn {
+// Reverse-mode differentiation of a compiled_net. forward() runs the input
+// rows in order from a cleared state, like compute() called once per row,
+// and records every step; backward() then takes the gradient of a loss
+// with respect to each output and returns it with respect to each gene in
+// one pass back through the steps, so feedback delays are differentiated
+// through time. Not safe to share between threads.
+class gradient_net {
+public:
+  typedef std::shared_ptr<gradient_net> ptr;
+
+  static ptr create(const compiled_net::ptr &net);
+
+  // output receives rows x output_count() values.
+  void forward(const std::vector<double> &weights,
+               const std::vector<double> &input,
+               std::vector<double> &output);
+  // output_gradient has the shape of forward()'s output; gradient
+  // receives weight_count() values.
+  void backward(const std::vector<double> &output_gradient,
+                std::vector<double> &gradient);
+
+  // Sum of squared errors against target (the shape of the output) and
+  // its gradient.
+  double loss_gradient(const std::vector<double> &weights,
+                       const std::vector<double> &input,
+                       const std::vector<double> &target,
+                       std::vector<double> &gradient);
+
+private:
+  gradient_net();
+  gradient_net(const gradient_net &) = delete;
+  gradient_net &operator=(const gradient_net &) = delete;
+
+  void backward_fusions();
+
+  compiled_net::ptr m_net;
+  compiled_net::context::ptr m_context;
+  size_t m_steps;
+
+  // Per step, the outputs and the sums of every layer, each laid out like
+  // the context's outputs.
+  std::vector<double> m_value;
+  std::vector<double> m_sum;
+
+  // Adjoints of the outputs of the current and the previous step, of sums
+  // delayed into later steps, and of the matrix.
+  std::vector<double> m_adjoint;
+  std::vector<double> m_carry;
+  std::vector<double> m_delayed;
+  std::vector<double> m_matrix;
+  std::vector<double> m_scratch;
+  std::vector<double> m_output;
+};
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "incremental_net.hpp"
+
+#include <algorithm>
+
+#include "activation.hpp"
+
+namespace ga4nn {
+namespace {
+double activate(compiled_net::activation kind, double z) {
+  if (kind == compiled_net::softsign_activation)
+    return softsign_function::apply(z);
+  return identity_function::apply(z);
+}
+}
+
+incremental_net::incremental_net() : m_samples(0) {}
+
+incremental_net::ptr incremental_net::create(const compiled_net::ptr &net,
+                                             const std::vector<double> &input) {
+  if (!net || !net->feedforward() || net->input_count() == 0)
+    return ptr();
+
+  ptr inc(new incremental_net());
+  inc->m_net = net;
+  inc->m_context = net->make_context();
+  inc->m_input = input;
+  inc->m_samples = input.size() / net->input_count();
+
+  const size_t layers = net->layer_count();
+  const size_t genes = net->weight_count();
+  inc->m_gene_layer.assign(genes, layers);
+  inc->m_gene_block.assign(genes, 0);
+  inc->m_gene_row.assign(genes, 0);
+  inc->m_gene_col.assign(genes, 0);
+
+  std::vector<size_t> gene_at(net->m_matrix.size(), genes);
+  for (size_t g = 0; g < genes; ++g)
+    gene_at[net->m_gene[g]] = g;
+
+  inc->m_kind.resize(layers);
+  for (size_t i = 0; i < layers; ++i) {
+    const compiled_net::layer_plan &l = net->get_layer(i);
+    inc->m_kind[i].assign(l.size, compiled_net::input_activation);
+    for (size_t s = 0; s < l.spans.size(); ++s)
+      std::fill(inc->m_kind[i].begin() + l.spans[s].first,
+                inc->m_kind[i].begin() + l.spans[s].last, l.spans[s].kind);
+    if (!l.computed)
+      continue;
+    for (size_t b = 0; b < l.blocks.size(); ++b) {
+      const compiled_net::block &bl = l.blocks[b];
+      if (bl.copy)
+        continue;
+      for (size_t r = 0; r < bl.rows; ++r) {
+        size_t first, last;
+        net->entry_range(bl, r, first, last);
+        for (size_t e = first; e < last; ++e) {
+          size_t g = gene_at[bl.offset + e];
+          if (g == genes)
+            continue;
+          inc->m_gene_layer[g] = i;
+          inc->m_gene_block[g] = b;
+          inc->m_gene_row[g] = r;
+          inc->m_gene_col[g] = net->entry_column(bl, r, e);
+        }
+      }
+    }
+  }
+
+  inc->m_sum.resize(layers);
+  inc->m_out.resize(layers);
+  inc->m_delta_sum.resize(layers);
+  inc->m_delta_out.resize(layers);
+  inc->m_touched.resize(layers);
+  inc->m_changed.resize(layers);
+  for (size_t i = 0; i < layers; ++i) {
+    const size_t n = inc->m_samples * net->get_layer(i).size;
+    inc->m_sum[i].assign(n, 0.0);
+    inc->m_out[i].assign(n, 0.0);
+    inc->m_delta_sum[i].assign(n, 0.0);
+    inc->m_delta_out[i].assign(n, 0.0);
+    inc->m_changed[i].assign(net->get_layer(i).size, false);
+  }
+
+  inc->set_base(net->get_weights(*inc->m_context));
+  return inc;
+}
+
+size_t incremental_net::sample_count() const { return m_samples; }
+
+void incremental_net::set_base(const std::vector<double> &genome) {
+  m_genome = genome;
+  m_genome.resize(m_net->weight_count(), 0.0);
+  m_net->set_weights(*m_context, m_genome);
+  evaluate_base();
+}
+
+const std::vector<double> &incremental_net::get_base() const {
+  return m_genome;
+}
+
+const std::vector<double> &incremental_net::base_output() const {
+  return m_out.back();
+}
+
+void incremental_net::evaluate_base() {
+  const compiled_net &net = *m_net;
+  const compiled_net::layer_plan &in = net.get_layer(0);
+  for (size_t r = 0; r < m_samples; ++r) {
+    for (size_t s = 0; s < in.spans.size(); ++s) {
+      const compiled_net::span &sp = in.spans[s];
+      if (sp.kind != compiled_net::input_activation)
+        continue;
+      for (size_t j = sp.first; j < sp.last; ++j)
+        m_out[0][r * in.size + j] = m_input[r * in.size + j];
+    }
+  }
+
+  for (size_t i = 0; i < net.layer_count(); ++i) {
+    const compiled_net::layer_plan &l = net.get_layer(i);
+    if (!l.computed || m_samples == 0)
+      continue;
+    std::fill(m_sum[i].begin(), m_sum[i].end(), 0.0);
+    for (size_t b = 0; b < l.blocks.size(); ++b) {
+      const compiled_net::block &bl = l.blocks[b];
+      net.multiply(bl, m_context->block[bl.index], &m_out[bl.source][0],
+                   m_samples, &m_sum[i][0]);
+    }
+    net.activate_rows(l, &m_sum[i][0], m_samples, &m_out[i][0]);
+  }
+}
+
+bool incremental_net::propagate(size_t gene, double value) {
+  const compiled_net &net = *m_net;
+  const size_t start = m_gene_layer[gene];
+  if (start == net.layer_count())
+    return false;
+
+  const double delta = value - m_genome[gene];
+  {
+    const compiled_net::layer_plan &l = net.get_layer(start);
+    const compiled_net::block &bl = l.blocks[m_gene_block[gene]];
+    const size_t r = m_gene_row[gene];
+    const size_t c = m_gene_col[gene];
+    const std::vector<double> &x = m_out[bl.source];
+    for (size_t s = 0; s < m_samples; ++s)
+      m_delta_sum[start][s * l.size + r] = delta * x[s * bl.cols + c];
+    m_touched[start].push_back(r);
+    m_changed[start][r] = true;
+  }
+
+  for (size_t i = start; i < net.layer_count(); ++i) {
+    const compiled_net::layer_plan &l = net.get_layer(i);
+    if (!l.computed)
+      continue;
+
+    if (i > start) {
+      for (size_t b = 0; b < l.blocks.size(); ++b) {
+        const compiled_net::block &bl = l.blocks[b];
+        const std::vector<bool> &changed = m_changed[bl.source];
+        if (m_touched[bl.source].empty())
+          continue;
+        const double *w = m_context->block[bl.index];
+        const std::vector<double> &dx = m_delta_out[bl.source];
+        for (size_t r = 0; r < bl.rows; ++r) {
+          size_t first, last;
+          net.entry_range(bl, r, first, last);
+          for (size_t e = first; e < last; ++e) {
+            size_t k = net.entry_column(bl, r, e);
+            if (!changed[k])
+              continue;
+            double weight = bl.copy ? 1.0 : w[e];
+            for (size_t s = 0; s < m_samples; ++s)
+              m_delta_sum[i][s * l.size + r] += weight * dx[s * bl.cols + k];
+            if (!m_changed[i][r]) {
+              m_changed[i][r] = true;
+              m_touched[i].push_back(r);
+            }
+          }
+        }
+      }
+    }
+
+    for (size_t t = 0; t < m_touched[i].size(); ++t) {
+      const size_t r = m_touched[i][t];
+      const compiled_net::activation kind = m_kind[i][r];
+      for (size_t s = 0; s < m_samples; ++s) {
+        const size_t at = s * l.size + r;
+        m_delta_out[i][at] =
+          activate(kind, m_sum[i][at] + m_delta_sum[i][at]) - m_out[i][at];
+      }
+    }
+  }
+  return true;
+}
+
+void incremental_net::clear_deltas() {
+  for (size_t i = 0; i < m_touched.size(); ++i) {
+    const size_t size = m_net->get_layer(i).size;
+    for (size_t t = 0; t < m_touched[i].size(); ++t) {
+      const size_t r = m_touched[i][t];
+      for (size_t s = 0; s < m_samples; ++s) {
+        m_delta_sum[i][s * size + r] = 0.0;
+        m_delta_out[i][s * size + r] = 0.0;
+      }
+      m_changed[i][r] = false;
+    }
+    m_touched[i].clear();
+  }
+}
+
+void incremental_net::evaluate_change(size_t gene, double value,
+                                      std::vector<double> &output) {
+  if (gene >= m_genome.size()) {
+    output = base_output();
+    return;
+  }
+
+  if (!propagate(gene, value)) {
+    std::vector<double> genome = m_genome;
+    genome[gene] = value;
+    compiled_net::context::ptr scratch = m_net->make_context();
+    m_net->bind_weights(*scratch, genome);
+    m_net->compute_batch(*scratch, m_input, output);
+    return;
+  }
+
+  output = m_out.back();
+  const std::vector<double> &d = m_delta_out.back();
+  for (size_t t = 0; t < m_touched.back().size(); ++t) {
+    const size_t r = m_touched.back()[t];
+    const size_t size = m_net->output_count();
+    for (size_t s = 0; s < m_samples; ++s)
+      output[s * size + r] += d[s * size + r];
+  }
+  clear_deltas();
+}
+
+void incremental_net::accept_change(size_t gene, double value) {
+  if (gene >= m_genome.size())
+    return;
+
+  if (!propagate(gene, value)) {
+    m_genome[gene] = value;
+    m_net->set_weight(*m_context, gene, value);
+    evaluate_base();
+    return;
+  }
+
+  for (size_t i = 0; i < m_touched.size(); ++i) {
+    const size_t size = m_net->get_layer(i).size;
+    for (size_t t = 0; t < m_touched[i].size(); ++t) {
+      const size_t r = m_touched[i][t];
+      for (size_t s = 0; s < m_samples; ++s) {
+        const size_t at = s * size + r;
+        m_sum[i][at] += m_delta_sum[i][at];
+        m_out[i][at] = activate(m_kind[i][r], m_sum[i][at]);
+      }
+    }
+  }
+  clear_deltas();
+  m_genome[gene] = value;
+  m_net->set_weight(*m_context, gene, value);
+}
+}
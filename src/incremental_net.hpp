@@ -0,0 +1,97 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __INCREMENTAL_NET_HPP
+#define __INCREMENTAL_NET_HPP
+#include <memory>
+#include <vector>
+
+#include "compiled_net.hpp"
+
+namespace ga4nn {
+// Evaluates a feed-forward plan over a fixed set of input rows and keeps
+// every layer's sums and outputs for a base genome. Changing one gene then
+// only moves the sums its link feeds: the change is pushed forward through
+// the neurons it reaches instead of re-running the whole net, which makes
+// probing genes one at a time much cheaper than full evaluations.
+class incremental_net {
+public:
+  typedef std::shared_ptr<incremental_net> ptr;
+
+  // Returns an empty ptr for recurrent plans.
+  static ptr create(const compiled_net::ptr &net,
+                    const std::vector<double> &input);
+
+  size_t sample_count() const;
+
+  void set_base(const std::vector<double> &genome);
+  const std::vector<double> &get_base() const;
+  // samples x output_count() outputs of the base genome.
+  const std::vector<double> &base_output() const;
+
+  // Outputs of the base genome with gene `gene` set to value; the base is
+  // left as it is.
+  void evaluate_change(size_t gene, double value, std::vector<double> &output);
+  // Makes the change part of the base.
+  void accept_change(size_t gene, double value);
+
+private:
+  incremental_net();
+  incremental_net(const incremental_net &) = delete;
+  incremental_net &operator=(const incremental_net &) = delete;
+
+  void evaluate_base();
+  // Fills the deltas of every neuron the change reaches; false when the
+  // gene was folded into a fused block and has no single link to follow.
+  bool propagate(size_t gene, double value);
+  void clear_deltas();
+
+  compiled_net::ptr m_net;
+  compiled_net::context::ptr m_context;
+  std::vector<double> m_input;
+  size_t m_samples;
+  std::vector<double> m_genome;
+
+  // Per gene: the layer evaluating its block, the block's position in that
+  // layer and the link's row and column; layer_count() when the block was
+  // fused away.
+  std::vector<size_t> m_gene_layer;
+  std::vector<size_t> m_gene_block;
+  std::vector<size_t> m_gene_row;
+  std::vector<size_t> m_gene_col;
+  std::vector<std::vector<compiled_net::activation> > m_kind;
+
+  // samples x size per layer: sums and outputs of the base genome and
+  // their deltas under the pending change, which are non-zero only in the
+  // columns listed in m_touched.
+  std::vector<std::vector<double> > m_sum;
+  std::vector<std::vector<double> > m_out;
+  std::vector<std::vector<double> > m_delta_sum;
+  std::vector<std::vector<double> > m_delta_out;
+  std::vector<std::vector<size_t> > m_touched;
+  std::vector<std::vector<bool> > m_changed;
+};
+}
+
+#endif
@@ -0,0 +1,242 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __ISLAND_HPP
+#define __ISLAND_HPP
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "genetic.hpp"
+
+namespace ga4nn {
+// Lock-free multi-producer, single-consumer queue. post() pushes onto a
+// Treiber stack; collect() detaches the whole stack with one exchange, so
+// the consumer never races the producers for single nodes and there is no
+// ABA problem.
+template<class T>
+class mailbox {
+public:
+  mailbox() : m_head(0) {}
+  ~mailbox() { release(m_head.exchange(0)); }
+
+  void post(const T &value) {
+    node *n = new node(value, m_head.load(std::memory_order_relaxed));
+    while (!m_head.compare_exchange_weak(n->next, n,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {}
+  }
+
+  // Appends everything posted so far to out, oldest first.
+  void collect(std::vector<T> &out) {
+    node *n = m_head.exchange(0, std::memory_order_acquire);
+    size_t first = out.size();
+    for (node *i = n; i; i = i->next)
+      out.push_back(i->value);
+    std::reverse(out.begin() + first, out.end());
+    release(n);
+  }
+
+private:
+  struct node {
+    T value;
+    node *next;
+    node(const T &value_, node *next_) : value(value_), next(next_) {}
+  };
+
+  mailbox(const mailbox &) = delete;
+  mailbox &operator=(const mailbox &) = delete;
+
+  static void release(node *n) {
+    while (n) {
+      node *next = n->next;
+      delete n;
+      n = next;
+    }
+  }
+
+  std::atomic<node *> m_head;
+};
+
+enum migration_topology {
+  ring_topology,
+  full_topology,
+  random_topology
+};
+
+// Island model: every island evolves its own population with its own
+// operators on its own thread. Every `interval` generations an island
+// sends copies of its `migrants` best genotypes to its neighbours (the
+// next island on a ring, every other island, or one island picked at
+// random) and takes in whatever has arrived in its mailbox, dropping its
+// worst genotype for each immigrant. Islands never wait for each other, so
+// migrants arrive whenever their senders get there. Operators and
+// Genotype::fitness() must be safe to use from several islands at once;
+// migrants are copied with Genotype's copy constructor.
+template< class Population,
+          class Selection,
+          class Crossover,
+          class Mutation>
+class island_model {
+public:
+  typedef typename Population::genotype genotype;
+  typedef typename std::shared_ptr<island_model> ptr;
+
+  island_model(migration_topology topology, size_t interval, size_t migrants,
+               unsigned seed = 1) :
+    m_topology(topology),
+    m_interval(interval),
+    m_migrants(migrants),
+    m_seed(seed) {}
+
+  void add_island(typename Population::ptr population,
+                  typename Selection::ptr selection,
+                  typename Crossover::ptr crossover,
+                  typename Mutation::ptr mutation) {
+    std::shared_ptr<island> i(new island);
+    i->population = population;
+    i->selection = selection;
+    i->crossover = crossover;
+    i->mutation = mutation;
+    m_island.push_back(i);
+  }
+
+  size_t island_count() const { return m_island.size(); }
+
+  typename Population::ptr get_population(size_t index) const {
+    if (index >= m_island.size())
+      return typename Population::ptr();
+    return m_island[index]->population;
+  }
+
+  // Runs generations generations on every island, one thread per island.
+  // Migrants still in a mailbox at the end are taken in before returning.
+  void run(size_t generations) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < m_island.size(); ++i)
+      threads.push_back(std::thread(&island_model::run_island, this, i,
+                                    generations));
+    for (size_t i = 0; i < threads.size(); ++i)
+      threads[i].join();
+
+    std::vector<typename genotype::ptr> arrived;
+    for (size_t i = 0; i < m_island.size(); ++i) {
+      arrived.clear();
+      m_island[i]->inbox.collect(arrived);
+      immigrate(*m_island[i], arrived);
+    }
+  }
+
+  // The best genotype over all islands; call it between runs. Populations
+  // have no way to look at their best genotype without taking it, so
+  // this takes it out of each island and puts it back.
+  typename genotype::ptr best() {
+    typename genotype::ptr b;
+    for (size_t i = 0; i < m_island.size(); ++i) {
+      typename genotype::ptr g = m_island[i]->population->take_beauty();
+      if (!g)
+        continue;
+      m_island[i]->population->insert(g);
+      if (!b || g->fitness() < b->fitness())
+        b = g;
+    }
+    return b;
+  }
+
+private:
+  struct island {
+    typename Population::ptr population;
+    typename Selection::ptr selection;
+    typename Crossover::ptr crossover;
+    typename Mutation::ptr mutation;
+    // The previous generation, kept to swap with rather than copy.
+    typename Population::ptr parents;
+    mailbox<typename genotype::ptr> inbox;
+  };
+
+  void run_island(size_t index, size_t generations) {
+    island &self = *m_island[index];
+    std::minstd_rand random(m_seed + static_cast<unsigned>(index));
+    std::vector<typename genotype::ptr> arrived;
+    for (size_t gen = 1; gen <= generations; ++gen) {
+      advance_generation<Population, Selection, Crossover, Mutation>(
+        self.parents, self.population, self.selection, self.crossover,
+        self.mutation);
+      if (m_interval == 0 || gen % m_interval != 0)
+        continue;
+      emigrate(index, random);
+      arrived.clear();
+      self.inbox.collect(arrived);
+      immigrate(self, arrived);
+    }
+  }
+
+  void emigrate(size_t index, std::minstd_rand &random) {
+    const size_t count = m_island.size();
+    if (count < 2)
+      return;
+    Population &p = *m_island[index]->population;
+    std::vector<typename genotype::ptr> best;
+    for (size_t i = 0; i < m_migrants && p.count() > 0; ++i)
+      best.push_back(p.take_beauty());
+    for (size_t i = 0; i < best.size(); ++i)
+      p.insert(best[i]);
+
+    std::vector<size_t> to;
+    if (m_topology == ring_topology) {
+      to.push_back((index + 1) % count);
+    } else if (m_topology == full_topology) {
+      for (size_t k = 1; k < count; ++k)
+        to.push_back((index + k) % count);
+    } else {
+      to.push_back((index + 1 + random() % (count - 1)) % count);
+    }
+    for (size_t t = 0; t < to.size(); ++t)
+      for (size_t i = 0; i < best.size(); ++i)
+        m_island[to[t]]->inbox.post(
+          typename genotype::ptr(new genotype(*best[i])));
+  }
+
+  static void immigrate(island &self,
+                        const std::vector<typename genotype::ptr> &arrived) {
+    for (size_t i = 0; i < arrived.size(); ++i) {
+      self.population->take_monster();
+      self.population->insert(arrived[i]);
+    }
+  }
+
+  migration_topology m_topology;
+  size_t m_interval;
+  size_t m_migrants;
+  unsigned m_seed;
+  std::vector<std::shared_ptr<island> > m_island;
+};
+}
+
+#endif
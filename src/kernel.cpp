@@ -0,0 +1,125 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "kernel.hpp"
+
+#include "activation.hpp"
+#include "kernel_impl.hpp"
+
+namespace ga4nn {
+namespace {
+struct scalar_isa {
+  static double dot(const double *a, const double *b, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      s += a[i] * b[i];
+    return s;
+  }
+
+  static void dot4(const double *a, const double *b0, const double *b1,
+                   const double *b2, const double *b3, size_t n,
+                   double *s) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      s0 += a[i] * b0[i];
+      s1 += a[i] * b1[i];
+      s2 += a[i] * b2[i];
+      s3 += a[i] * b3[i];
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+  }
+
+  static double gather_dot(const double *a, const size_t *col,
+                           const double *x, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      s += a[i] * x[col[i]];
+    return s;
+  }
+
+  static void softsign(const double *z, size_t n, double *out) {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = softsign_function::apply(z[i]);
+  }
+};
+
+typedef kernel_impl<scalar_isa> scalar_impl;
+
+const kernels scalar_table = {
+  "scalar",
+  scalar_impl::gemv,
+  scalar_impl::gemm,
+  scalar_impl::spmv,
+  scalar_impl::spmm,
+  scalar_isa::softsign,
+  scalar_impl::linear
+};
+
+enum isa {
+  sse2_isa,
+  avx2_isa,
+  avx512_isa
+};
+
+bool cpu_supports(isa i) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (i == avx512_isa)
+    return __builtin_cpu_supports("avx512f");
+  if (i == avx2_isa)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return __builtin_cpu_supports("sse2");
+#else
+  (void)i;
+  return false;
+#endif
+}
+
+const kernels &select_kernels() {
+  if (avx512_supported())
+    return *avx512_kernels();
+  if (avx2_supported())
+    return *avx2_kernels();
+  if (sse2_supported())
+    return *sse2_kernels();
+  return scalar_table;
+}
+}
+
+const kernels &scalar_kernels() { return scalar_table; }
+
+bool sse2_supported() { return sse2_kernels() && cpu_supports(sse2_isa); }
+
+bool avx2_supported() { return avx2_kernels() && cpu_supports(avx2_isa); }
+
+bool avx512_supported() { return avx512_kernels() && cpu_supports(avx512_isa); }
+
+const kernels &best_kernels() {
+  static const kernels &k = select_kernels();
+  return k;
+}
+}
@@ -0,0 +1,70 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __KERNEL_HPP
+#define __KERNEL_HPP
+#include <cstdlib>
+
+namespace ga4nn {
+// Dense forward pass and activation kernels used by compiled_net. Every
+// instruction set provides the same table; best_kernels() picks the widest
+// one the running CPU supports.
+struct kernels {
+  const char *name;
+  // y[r] += w[r] . x for every row r of the rows x cols matrix w.
+  void (*gemv)(const double *w, size_t rows, size_t cols,
+               const double *x, double *y);
+  // y[s][r] += w[r] . x[s] for count samples; x is count x cols and y is
+  // count x rows, both row-major.
+  void (*gemm)(const double *w, size_t rows, size_t cols,
+               const double *x, size_t count, double *y);
+  // Sparse counterparts in CSR form: row r holds the values
+  // w[row[r] .. row[r + 1]) at columns col[row[r] .. row[r + 1]).
+  void (*spmv)(const double *w, const size_t *row, const size_t *col,
+               size_t rows, const double *x, double *y);
+  void (*spmm)(const double *w, const size_t *row, const size_t *col,
+               size_t rows, size_t cols, const double *x, size_t count,
+               double *y);
+  // out[i] = z[i] / (1 + |z[i]|)
+  void (*softsign)(const double *z, size_t n, double *out);
+  // out[i] = z[i]
+  void (*linear)(const double *z, size_t n, double *out);
+};
+
+const kernels &scalar_kernels();
+// Null when the table is not built for this target. A table that is built
+// may still need instructions the running CPU lacks; only call it when
+// the matching *_supported() says so.
+const kernels *sse2_kernels();
+const kernels *avx2_kernels();
+const kernels *avx512_kernels();
+
+bool sse2_supported();
+bool avx2_supported();
+bool avx512_supported();
+
+const kernels &best_kernels();
+}
+
+#endif
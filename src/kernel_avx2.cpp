@@ -0,0 +1,132 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "kernel.hpp"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+#include "kernel_impl.hpp"
+
+namespace ga4nn {
+namespace {
+inline double hsum(__m256d v) {
+  __m128d lo = _mm256_castpd256_pd128(v);
+  __m128d hi = _mm256_extractf128_pd(v, 1);
+  lo = _mm_add_pd(lo, hi);
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+struct avx2_isa {
+  static double dot(const double *a, const double *b, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+      acc = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i),
+                            acc);
+    double s = hsum(acc);
+    for (; i < n; ++i)
+      s += a[i] * b[i];
+    return s;
+  }
+
+  static void dot4(const double *a, const double *b0, const double *b1,
+                   const double *b2, const double *b3, size_t n,
+                   double *s) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m256d va = _mm256_loadu_pd(a + i);
+      acc0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(b0 + i), acc0);
+      acc1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(b1 + i), acc1);
+      acc2 = _mm256_fmadd_pd(va, _mm256_loadu_pd(b2 + i), acc2);
+      acc3 = _mm256_fmadd_pd(va, _mm256_loadu_pd(b3 + i), acc3);
+    }
+    s[0] = hsum(acc0);
+    s[1] = hsum(acc1);
+    s[2] = hsum(acc2);
+    s[3] = hsum(acc3);
+    for (; i < n; ++i) {
+      s[0] += a[i] * b0[i];
+      s[1] += a[i] * b1[i];
+      s[2] += a[i] * b2[i];
+      s[3] += a[i] * b3[i];
+    }
+  }
+
+  static double gather_dot(const double *a, const size_t *col,
+                           const double *x, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+#if defined(__x86_64__)
+    for (; i + 4 <= n; i += 4) {
+      __m256i idx = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(col + i));
+      acc = _mm256_fmadd_pd(_mm256_loadu_pd(a + i),
+                            _mm256_i64gather_pd(x, idx, 8), acc);
+    }
+#endif
+    double s = hsum(acc);
+    for (; i < n; ++i)
+      s += a[i] * x[col[i]];
+    return s;
+  }
+
+  static void softsign(const double *z, size_t n, double *out) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m256d v = _mm256_loadu_pd(z + i);
+      __m256d d = _mm256_add_pd(one, _mm256_andnot_pd(sign, v));
+      _mm256_storeu_pd(out + i, _mm256_div_pd(v, d));
+    }
+    for (; i < n; ++i)
+      out[i] = z[i] / (1 + (z[i] < 0 ? -z[i] : z[i]));
+  }
+};
+
+typedef kernel_impl<avx2_isa> avx2_impl;
+
+const kernels avx2_table = {
+  "avx2",
+  avx2_impl::gemv,
+  avx2_impl::gemm,
+  avx2_impl::spmv,
+  avx2_impl::spmm,
+  avx2_isa::softsign,
+  avx2_impl::linear
+};
+}
+
+const kernels *avx2_kernels() { return &avx2_table; }
+}
+#else
+namespace ga4nn {
+const kernels *avx2_kernels() { return 0; }
+}
+#endif
@@ -0,0 +1,135 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "kernel.hpp"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+#include "kernel_impl.hpp"
+
+namespace ga4nn {
+namespace {
+inline __mmask8 tail_mask(size_t n) {
+  return static_cast<__mmask8>((1u << n) - 1);
+}
+
+struct avx512_isa {
+  static double dot(const double *a, const double *b, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+      acc = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i),
+                            acc);
+    if (i < n) {
+      __mmask8 m = tail_mask(n - i);
+      acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + i),
+                            _mm512_maskz_loadu_pd(m, b + i), acc);
+    }
+    return _mm512_reduce_add_pd(acc);
+  }
+
+  static void dot4(const double *a, const double *b0, const double *b1,
+                   const double *b2, const double *b3, size_t n,
+                   double *s) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd();
+    __m512d acc3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m512d va = _mm512_loadu_pd(a + i);
+      acc0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(b0 + i), acc0);
+      acc1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(b1 + i), acc1);
+      acc2 = _mm512_fmadd_pd(va, _mm512_loadu_pd(b2 + i), acc2);
+      acc3 = _mm512_fmadd_pd(va, _mm512_loadu_pd(b3 + i), acc3);
+    }
+    if (i < n) {
+      __mmask8 m = tail_mask(n - i);
+      __m512d va = _mm512_maskz_loadu_pd(m, a + i);
+      acc0 = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m, b0 + i), acc0);
+      acc1 = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m, b1 + i), acc1);
+      acc2 = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m, b2 + i), acc2);
+      acc3 = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m, b3 + i), acc3);
+    }
+    s[0] = _mm512_reduce_add_pd(acc0);
+    s[1] = _mm512_reduce_add_pd(acc1);
+    s[2] = _mm512_reduce_add_pd(acc2);
+    s[3] = _mm512_reduce_add_pd(acc3);
+  }
+
+  static double gather_dot(const double *a, const size_t *col,
+                           const double *x, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+#if defined(__x86_64__)
+    for (; i + 8 <= n; i += 8) {
+      __m512i idx = _mm512_loadu_si512(col + i);
+      acc = _mm512_fmadd_pd(_mm512_loadu_pd(a + i),
+                            _mm512_i64gather_pd(idx, x, 8), acc);
+    }
+#endif
+    double s = _mm512_reduce_add_pd(acc);
+    for (; i < n; ++i)
+      s += a[i] * x[col[i]];
+    return s;
+  }
+
+  static void softsign(const double *z, size_t n, double *out) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m512d v = _mm512_loadu_pd(z + i);
+      __m512d d = _mm512_add_pd(one, _mm512_abs_pd(v));
+      _mm512_storeu_pd(out + i, _mm512_div_pd(v, d));
+    }
+    if (i < n) {
+      __mmask8 m = tail_mask(n - i);
+      __m512d v = _mm512_maskz_loadu_pd(m, z + i);
+      __m512d d = _mm512_add_pd(one, _mm512_abs_pd(v));
+      _mm512_mask_storeu_pd(out + i, m, _mm512_div_pd(v, d));
+    }
+  }
+};
+
+typedef kernel_impl<avx512_isa> avx512_impl;
+
+const kernels avx512_table = {
+  "avx512",
+  avx512_impl::gemv,
+  avx512_impl::gemm,
+  avx512_impl::spmv,
+  avx512_impl::spmm,
+  avx512_isa::softsign,
+  avx512_impl::linear
+};
+}
+
+const kernels *avx512_kernels() { return &avx512_table; }
+}
+#else
+namespace ga4nn {
+const kernels *avx512_kernels() { return 0; }
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __KERNEL_IMPL_HPP
+#define __KERNEL_IMPL_HPP
+#include <cstdlib>
+
+namespace ga4nn {
+// Loop nests shared by all kernel tables. Isa supplies dot(), dot4() (four
+// dot products sharing the vector a), gather_dot() (a . x[col]) plus the
+// activation loops, and must have internal linkage so the instantiations
+// compiled with different target flags never get merged by the linker.
+template <class Isa>
+struct kernel_impl {
+  static void gemv(const double *w, size_t rows, size_t cols,
+                   const double *x, double *y) {
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+      double s[4];
+      Isa::dot4(x, w + r * cols, w + (r + 1) * cols,
+                w + (r + 2) * cols, w + (r + 3) * cols, cols, s);
+      y[r] += s[0];
+      y[r + 1] += s[1];
+      y[r + 2] += s[2];
+      y[r + 3] += s[3];
+    }
+    for (; r < rows; ++r)
+      y[r] += Isa::dot(x, w + r * cols, cols);
+  }
+
+  static void gemm(const double *w, size_t rows, size_t cols,
+                   const double *x, size_t count, double *y) {
+    for (size_t r = 0; r < rows; ++r) {
+      const double *row = w + r * cols;
+      size_t s = 0;
+      for (; s + 4 <= count; s += 4) {
+        double d[4];
+        Isa::dot4(row, x + s * cols, x + (s + 1) * cols,
+                  x + (s + 2) * cols, x + (s + 3) * cols, cols, d);
+        y[s * rows + r] += d[0];
+        y[(s + 1) * rows + r] += d[1];
+        y[(s + 2) * rows + r] += d[2];
+        y[(s + 3) * rows + r] += d[3];
+      }
+      for (; s < count; ++s)
+        y[s * rows + r] += Isa::dot(row, x + s * cols, cols);
+    }
+  }
+
+  static void spmv(const double *w, const size_t *row, const size_t *col,
+                   size_t rows, const double *x, double *y) {
+    for (size_t r = 0; r < rows; ++r)
+      y[r] += Isa::gather_dot(w + row[r], col + row[r], x,
+                              row[r + 1] - row[r]);
+  }
+
+  static void spmm(const double *w, const size_t *row, const size_t *col,
+                   size_t rows, size_t cols, const double *x, size_t count,
+                   double *y) {
+    for (size_t s = 0; s < count; ++s)
+      spmv(w, row, col, rows, x + s * cols, y + s * rows);
+  }
+
+  static void linear(const double *z, size_t n, double *out) {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = z[i];
+  }
+};
+}
+
+#endif
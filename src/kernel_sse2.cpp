@@ -0,0 +1,124 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "kernel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+#include "kernel_impl.hpp"
+
+namespace ga4nn {
+namespace {
+inline double hsum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+struct sse2_isa {
+  static double dot(const double *a, const double *b, size_t n) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+      acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i),
+                                       _mm_loadu_pd(b + i)));
+    double s = hsum(acc);
+    for (; i < n; ++i)
+      s += a[i] * b[i];
+    return s;
+  }
+
+  static void dot4(const double *a, const double *b0, const double *b1,
+                   const double *b2, const double *b3, size_t n,
+                   double *s) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+      __m128d va = _mm_loadu_pd(a + i);
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(va, _mm_loadu_pd(b0 + i)));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(va, _mm_loadu_pd(b1 + i)));
+      acc2 = _mm_add_pd(acc2, _mm_mul_pd(va, _mm_loadu_pd(b2 + i)));
+      acc3 = _mm_add_pd(acc3, _mm_mul_pd(va, _mm_loadu_pd(b3 + i)));
+    }
+    s[0] = hsum(acc0);
+    s[1] = hsum(acc1);
+    s[2] = hsum(acc2);
+    s[3] = hsum(acc3);
+    for (; i < n; ++i) {
+      s[0] += a[i] * b0[i];
+      s[1] += a[i] * b1[i];
+      s[2] += a[i] * b2[i];
+      s[3] += a[i] * b3[i];
+    }
+  }
+
+  static double gather_dot(const double *a, const size_t *col,
+                           const double *x, size_t n) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+      acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i),
+                                       _mm_set_pd(x[col[i + 1]], x[col[i]])));
+    double s = hsum(acc);
+    for (; i < n; ++i)
+      s += a[i] * x[col[i]];
+    return s;
+  }
+
+  static void softsign(const double *z, size_t n, double *out) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+      __m128d v = _mm_loadu_pd(z + i);
+      __m128d d = _mm_add_pd(one, _mm_andnot_pd(sign, v));
+      _mm_storeu_pd(out + i, _mm_div_pd(v, d));
+    }
+    for (; i < n; ++i)
+      out[i] = z[i] / (1 + (z[i] < 0 ? -z[i] : z[i]));
+  }
+};
+
+typedef kernel_impl<sse2_isa> sse2_impl;
+
+const kernels sse2_table = {
+  "sse2",
+  sse2_impl::gemv,
+  sse2_impl::gemm,
+  sse2_impl::spmv,
+  sse2_impl::spmm,
+  sse2_isa::softsign,
+  sse2_impl::linear
+};
+}
+
+const kernels *sse2_kernels() { return &sse2_table; }
+}
+#else
+namespace ga4nn {
+const kernels *sse2_kernels() { return 0; }
+}
+#endif
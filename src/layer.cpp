@@ -24,9 +24,16 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #include "layer.hpp"
 
+#include <algorithm>
+
 namespace ga4nn {
+layer::layer(const arena::ptr &a) : m_arena(a), m_revision(0) {}
 layer::~layer() {}
 
+size_t layer::revision() const { return m_revision; }
+
+const arena::ptr &layer::get_arena() const { return m_arena; }
+
 size_t layer::neuron_count() const { return m_neuron.size(); }
 
 neuron::ptr layer::get_neuron(size_t index) const {
@@ -59,6 +66,15 @@ std::vector<double> layer::get_weights() const {
   return weights;
 }
 
+size_t layer::weights_into(double *weights, size_t size) const {
+  size_t count = 0;
+  for (size_t i = 0; i < m_neuron.size(); ++i) {
+    size_t written = std::min(count, size);
+    count += m_neuron[i]->weights_into(weights + written, size - written);
+  }
+  return count;
+}
+
 void layer::compute() {
   for (size_t i = 0; i < m_neuron.size(); ++i)
     m_neuron[i]->compute();
@@ -72,10 +88,21 @@ void layer::set_outputs(std::vector<double>::const_iterator &first,
   }
 }
 
+void layer::set_outputs(const double *values, size_t count) {
+  for (size_t i = 0; i < m_neuron.size() && i < count; ++i)
+    m_neuron[i]->set_output(values[i]);
+}
+
 std::vector<double> layer::get_outputs() const {
   std::vector<double> outputs;
   for (size_t i = 0; i < m_neuron.size(); ++i)
     outputs.push_back(m_neuron[i]->get_output());
   return outputs;
 }
+
+size_t layer::outputs_into(double *outputs, size_t size) const {
+  for (size_t i = 0; i < m_neuron.size() && i < size; ++i)
+    outputs[i] = m_neuron[i]->get_output();
+  return m_neuron.size();
+}
 }
@@ -42,29 +42,35 @@ public:
         : link_back(l_back), neuron_front(n_front) {}
   };
 
+  // With an arena, neurons, links and connections made by this layer are
+  // allocated from it instead of one heap allocation each. Each of them
+  // keeps the arena alive, so they may outlive the layer.
+  explicit layer(const arena::ptr &a = arena::ptr());
   ~layer();
 
+  const arena::ptr &get_arena() const;
+
+  // Changes whenever neurons or connections are added.
+  size_t revision() const;
+
   template <class Factory> void add_neurons(Factory factory, size_t count) {
+    ++m_revision;
+    m_neuron.reserve(m_neuron.size() + count);
     for (size_t i = 0; i < count; ++i)
-      m_neuron.push_back(factory.create_neuron());
+      m_neuron.push_back(create_neuron(factory, m_arena, 0));
   }
 
   size_t neuron_count() const;
   neuron::ptr get_neuron(size_t index) const;
 
+  // Connectors that describe their pattern row by row (see connector.hpp)
+  // are built in time proportional to the links they create; others are
+  // asked about every (back, front) pair. Links are created front neuron by
+  // front neuron in both cases.
   template <class Connector>
   void connect_back(const layer::ptr &l_back, Connector connector) {
-    for (size_t i = 0; i < m_neuron.size(); ++i) {
-      const neuron::ptr &n_front = m_neuron[i];
-      for (size_t j = 0; j < l_back->neuron_count(); ++j) {
-        neuron::ptr n_back = l_back->get_neuron(j);
-        if (connector.valid_connection(j, i))
-          m_connection.push_back(connection::ptr(
-              new connection(n_front->create_link(n_back,
-                              connector.weight(),
-                              connector.constant()), n_front)));
-      }
-    }
+    ++m_revision;
+    connect_back(l_back, connector, 0);
   }
 
   size_t connection_count() const;
@@ -73,14 +79,67 @@ public:
   void set_weights(std::vector<double>::const_iterator &first,
                    const std::vector<double>::const_iterator &last);
   std::vector<double> get_weights() const;
+  size_t weights_into(double *weights, size_t size) const;
 
   void compute();
 
   void set_outputs(std::vector<double>::const_iterator &first,
                    const std::vector<double>::const_iterator &last);
+  void set_outputs(const double *values, size_t count);
   std::vector<double> get_outputs() const;
+  size_t outputs_into(double *outputs, size_t size) const;
 
 protected:
+  // Factories without an arena overload of create_neuron() still work;
+  // their neurons just come from the heap.
+  template <class Factory>
+  static auto create_neuron(Factory &factory, const arena::ptr &a, int)
+      -> decltype(factory.create_neuron(a)) {
+    return factory.create_neuron(a);
+  }
+  template <class Factory>
+  static neuron::ptr create_neuron(Factory &factory, const arena::ptr &,
+                                   long) {
+    return factory.create_neuron();
+  }
+
+  template <class Connector>
+  auto connect_back(const layer::ptr &l_back, Connector &connector, int)
+      -> decltype(connector.connection_count(0, 0), void()) {
+    m_connection.reserve(m_connection.size()
+        + connector.connection_count(l_back->neuron_count(), m_neuron.size()));
+    std::vector<size_t> back;
+    for (size_t i = 0; i < m_neuron.size(); ++i) {
+      const neuron::ptr &n_front = m_neuron[i];
+      connector.row(i, l_back->neuron_count(), back);
+      n_front->reserve_links(back.size());
+      for (size_t k = 0; k < back.size(); ++k)
+        connect(l_back->m_neuron[back[k]], n_front, connector);
+    }
+  }
+
+  template <class Connector>
+  void connect_back(const layer::ptr &l_back, Connector &connector, long) {
+    for (size_t i = 0; i < m_neuron.size(); ++i) {
+      const neuron::ptr &n_front = m_neuron[i];
+      for (size_t j = 0; j < l_back->neuron_count(); ++j)
+        if (connector.valid_connection(j, i))
+          connect(l_back->m_neuron[j], n_front, connector);
+    }
+  }
+
+  template <class Connector>
+  void connect(const neuron::ptr &n_back, const neuron::ptr &n_front,
+               Connector &connector) {
+    m_connection.push_back(make_shared_in<connection>(m_arena,
+        n_front->create_link(n_back,
+                             connector.weight(),
+                             connector.constant(),
+                             m_arena), n_front));
+  }
+
+  arena::ptr m_arena;
+  size_t m_revision;
   std::vector<neuron::ptr> m_neuron;
   std::vector<connection::ptr> m_connection;
 };
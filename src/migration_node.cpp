@@ -0,0 +1,425 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "migration_node.hpp"
+
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ga4nn {
+namespace {
+// Frames above this size are taken for a corrupt stream, so send()
+// refuses them.
+const size_t max_frame = 1 << 26;
+
+struct endpoint {
+  sockaddr_storage addr;
+  socklen_t length;
+  int family;
+  std::string path;
+};
+
+bool resolve(const std::string &address, endpoint &e) {
+  std::memset(&e.addr, 0, sizeof(e.addr));
+  if (address.compare(0, 5, "unix:") == 0) {
+    sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&e.addr);
+    e.path = address.substr(5);
+    if (e.path.empty() || e.path.size() >= sizeof(un->sun_path))
+      return false;
+    un->sun_family = AF_UNIX;
+    std::strcpy(un->sun_path, e.path.c_str());
+    e.length = sizeof(sockaddr_un);
+    e.family = AF_UNIX;
+    return true;
+  }
+
+  if (address.compare(0, 4, "tcp:") != 0)
+    return false;
+  size_t colon = address.rfind(':');
+  if (colon <= 4)
+    return false;
+  std::string host = address.substr(4, colon - 4);
+  std::string port = address.substr(colon + 1);
+  addrinfo hints, *found = 0;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0 || !found)
+    return false;
+  std::memcpy(&e.addr, found->ai_addr, found->ai_addrlen);
+  e.length = found->ai_addrlen;
+  e.family = found->ai_family;
+  freeaddrinfo(found);
+  return true;
+}
+
+struct incoming {
+  int fd;
+  std::vector<unsigned char> buffer;
+};
+
+// Bytes queued for a neighbour; buffer[0 .. sent) is already written.
+struct outgoing {
+  int fd;
+  std::vector<unsigned char> buffer;
+  size_t sent;
+};
+
+void set_nonblocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// A socket file nobody listens on any more refuses connections; one of a
+// live node accepts them.
+bool stale_socket(const endpoint &e) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  bool stale =
+    ::connect(fd, reinterpret_cast<const sockaddr *>(&e.addr), e.length) != 0
+    && errno == ECONNREFUSED;
+  close(fd);
+  return stale;
+}
+}
+
+struct migration_node::prv {
+  int listener;
+  std::string address;
+  std::string path;
+  // The socket file bound at path, so that only it is unlinked.
+  dev_t device;
+  ino_t inode;
+  std::vector<outgoing> peers;
+  std::vector<incoming> sources;
+  // Frames read by flush(), handed out by the next receive().
+  std::vector<std::vector<unsigned char> > held;
+
+  prv() : listener(-1) {}
+  ~prv() {
+    for (size_t i = 0; i < peers.size(); ++i)
+      close(peers[i].fd);
+    for (size_t i = 0; i < sources.size(); ++i)
+      close(sources[i].fd);
+    if (listener >= 0)
+      close(listener);
+    struct stat st;
+    if (!path.empty() && lstat(path.c_str(), &st) == 0
+        && st.st_dev == device && st.st_ino == inode)
+      unlink(path.c_str());
+  }
+
+  void accept_pending() {
+    for (;;) {
+      int fd = accept(listener, 0, 0);
+      if (fd < 0)
+        return;
+      set_nonblocking(fd);
+      incoming in;
+      in.fd = fd;
+      sources.push_back(in);
+    }
+  }
+
+  // Reads what is there and cuts it into frames; false once the
+  // connection is closed or corrupt.
+  bool read(incoming &in, std::vector<std::vector<unsigned char> > &frames) {
+    bool open = true;
+    unsigned char chunk[4096];
+    for (;;) {
+      ssize_t n = recv(in.fd, chunk, sizeof(chunk), 0);
+      if (n > 0) {
+        in.buffer.insert(in.buffer.end(), chunk, chunk + n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR)
+        continue;
+      open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+      break;
+    }
+
+    size_t at = 0;
+    while (in.buffer.size() - at >= 4) {
+      size_t size = 0;
+      for (size_t i = 0; i < 4; ++i)
+        size |= static_cast<size_t>(in.buffer[at + i]) << (8 * i);
+      if (size > max_frame)
+        return false;
+      if (in.buffer.size() - at - 4 < size)
+        break;
+      frames.push_back(std::vector<unsigned char>(
+        in.buffer.begin() + at + 4, in.buffer.begin() + at + 4 + size));
+      at += 4 + size;
+    }
+    in.buffer.erase(in.buffer.begin(), in.buffer.begin() + at);
+    return open;
+  }
+
+  void read_sources(std::vector<std::vector<unsigned char> > &frames) {
+    accept_pending();
+    for (size_t i = 0; i < sources.size();) {
+      if (read(sources[i], frames)) {
+        ++i;
+        continue;
+      }
+      close(sources[i].fd);
+      sources.erase(sources.begin() + i);
+    }
+  }
+
+  // Writes as much as the socket takes right now; false once the
+  // neighbour has gone away.
+  bool write(outgoing &out) {
+    while (out.sent < out.buffer.size()) {
+      ssize_t n = ::send(out.fd, &out.buffer[out.sent],
+                         out.buffer.size() - out.sent, MSG_NOSIGNAL);
+      if (n > 0) {
+        out.sent += n;
+        continue;
+      }
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+      return false;
+    }
+    if (out.sent == out.buffer.size()) {
+      out.buffer.clear();
+      out.sent = 0;
+    } else if (out.sent >= out.buffer.size() / 2) {
+      out.buffer.erase(out.buffer.begin(), out.buffer.begin() + out.sent);
+      out.sent = 0;
+    }
+    return true;
+  }
+
+  void drop_peer(size_t i) {
+    close(peers[i].fd);
+    peers.erase(peers.begin() + i);
+  }
+
+  // Writes to the neighbours with queued bytes that poll() finds ready,
+  // waiting up to timeout_ms for one to become so.
+  void flush_peers(int timeout_ms) {
+    std::vector<pollfd> ready;
+    for (size_t i = 0; i < peers.size(); ++i) {
+      if (peers[i].sent == peers[i].buffer.size())
+        continue;
+      pollfd p = {peers[i].fd, POLLOUT, 0};
+      ready.push_back(p);
+    }
+    if (ready.empty() || poll(&ready[0], ready.size(), timeout_ms) <= 0)
+      return;
+    for (size_t i = 0, k = 0; i < peers.size() && k < ready.size();) {
+      if (peers[i].fd != ready[k].fd) {
+        ++i;
+        continue;
+      }
+      if (ready[k++].revents == 0 || write(peers[i]))
+        ++i;
+      else
+        drop_peer(i);
+    }
+  }
+
+  size_t pending() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < peers.size(); ++i)
+      bytes += peers[i].buffer.size() - peers[i].sent;
+    return bytes;
+  }
+};
+
+migration_node::migration_node() : d(new prv) {}
+
+migration_node::~migration_node() {}
+
+migration_node::ptr migration_node::create(const std::string &address) {
+  endpoint e;
+  if (!resolve(address, e))
+    return ptr();
+
+  ptr node(new migration_node);
+  int fd = socket(e.family, SOCK_STREAM, 0);
+  if (fd < 0)
+    return ptr();
+  node->d->listener = fd;
+  if (e.family == AF_UNIX) {
+    // Only a socket left behind by an earlier run is replaced.
+    struct stat st;
+    if (lstat(e.path.c_str(), &st) == 0) {
+      if (!S_ISSOCK(st.st_mode) || !stale_socket(e))
+        return ptr();
+      unlink(e.path.c_str());
+    }
+  } else {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  }
+  if (bind(fd, reinterpret_cast<sockaddr *>(&e.addr), e.length) != 0
+      || listen(fd, 64) != 0)
+    return ptr();
+  set_nonblocking(fd);
+  if (e.family == AF_UNIX) {
+    struct stat st;
+    if (lstat(e.path.c_str(), &st) != 0)
+      return ptr();
+    node->d->path = e.path;
+    node->d->device = st.st_dev;
+    node->d->inode = st.st_ino;
+  }
+
+  node->d->address = address;
+  if (e.family != AF_UNIX) {
+    sockaddr_storage bound;
+    socklen_t length = sizeof(bound);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&bound), &length);
+    unsigned port = ntohs(e.family == AF_INET
+      ? reinterpret_cast<sockaddr_in *>(&bound)->sin_port
+      : reinterpret_cast<sockaddr_in6 *>(&bound)->sin6_port);
+    size_t colon = address.rfind(':');
+    node->d->address = address.substr(0, colon + 1) + std::to_string(port);
+  }
+  return node;
+}
+
+std::string migration_node::address() const { return d->address; }
+
+bool migration_node::connect(const std::string &address, int timeout_ms) {
+  endpoint e;
+  if (!resolve(address, e))
+    return false;
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  for (;;) {
+    int fd = socket(e.family, SOCK_STREAM, 0);
+    if (fd < 0)
+      return false;
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&e.addr), e.length) == 0) {
+      if (e.family != AF_UNIX) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      }
+      set_nonblocking(fd);
+      outgoing out;
+      out.fd = fd;
+      out.sent = 0;
+      d->peers.push_back(out);
+      return true;
+    }
+    close(fd);
+    if (std::chrono::steady_clock::now() >= end)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+size_t migration_node::peer_count() const { return d->peers.size(); }
+
+bool migration_node::send(const std::vector<unsigned char> &frame) {
+  if (frame.size() > max_frame)
+    return false;
+  unsigned char prefix[4];
+  for (size_t i = 0; i < 4; ++i)
+    prefix[i] = static_cast<unsigned char>(frame.size() >> (8 * i));
+  for (size_t i = 0; i < d->peers.size();) {
+    outgoing &out = d->peers[i];
+    out.buffer.insert(out.buffer.end(), prefix, prefix + 4);
+    out.buffer.insert(out.buffer.end(), frame.begin(), frame.end());
+    if (d->write(out))
+      ++i;
+    else
+      d->drop_peer(i);
+  }
+  return true;
+}
+
+void migration_node::receive(std::vector<std::vector<unsigned char> > &frames) {
+  for (size_t i = 0; i < d->held.size(); ++i)
+    frames.push_back(std::move(d->held[i]));
+  d->held.clear();
+  d->flush_peers(0);
+  d->read_sources(frames);
+}
+
+size_t migration_node::max_frame_size() { return max_frame; }
+
+size_t migration_node::pending() const { return d->pending(); }
+
+bool migration_node::flush(int timeout_ms) {
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  for (;;) {
+    // Reading meanwhile keeps a neighbour flushing towards us unblocked.
+    d->read_sources(d->held);
+    if (d->pending() == 0)
+      return true;
+    std::chrono::steady_clock::duration left =
+      end - std::chrono::steady_clock::now();
+    if (left <= std::chrono::steady_clock::duration::zero())
+      return false;
+    d->flush_peers(static_cast<int>(std::min<long long>(10,
+      std::chrono::duration_cast<std::chrono::milliseconds>(left).count()
+      + 1)));
+  }
+}
+
+bool launch_workers(size_t count, const std::function<int(size_t)> &worker) {
+  std::vector<pid_t> children;
+  bool ok = true;
+  for (size_t i = 0; i < count; ++i) {
+    pid_t pid = fork();
+    if (pid == 0)
+      _exit(worker(i));
+    if (pid < 0) {
+      ok = false;
+      break;
+    }
+    children.push_back(pid);
+  }
+  for (size_t i = 0; i < children.size(); ++i) {
+    int status = 0;
+    if (waitpid(children[i], &status, 0) != children[i]
+        || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      ok = false;
+  }
+  return ok;
+}
+}
@@ -0,0 +1,90 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __MIGRATION_NODE_HPP
+#define __MIGRATION_NODE_HPP
+#include <cstdlib>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ga4nn {
+// Endpoint of an island running in its own process. A node listens on an
+// address, "unix:/path/to/socket" or "tcp:host:port", and sends frames to
+// the neighbours it connected to; frames are length-prefixed byte blocks,
+// normally genome blocks from encode_genomes(). POSIX only.
+class migration_node {
+public:
+  typedef std::shared_ptr<migration_node> ptr;
+
+  // Returns an empty ptr if the address cannot be bound. A TCP port of 0
+  // picks a free port; address() tells which. A Unix socket path may only
+  // name nothing or a socket no node listens on any more, which is
+  // replaced; the node removes its socket file when it is destroyed.
+  static ptr create(const std::string &address);
+  virtual ~migration_node();
+
+  std::string address() const;
+
+  // The neighbour may still be starting up, so connecting is retried
+  // until timeout_ms has passed.
+  bool connect(const std::string &address, int timeout_ms = 5000);
+  size_t peer_count() const;
+
+  // Queues frame for every connected neighbour and writes what the
+  // sockets take without waiting; the rest goes out on later send(),
+  // receive() and flush() calls, so islands sending to each other never
+  // block. A neighbour that has gone away is dropped. Frames over
+  // max_frame_size() bytes are refused with false and sent to no one.
+  bool send(const std::vector<unsigned char> &frame);
+  static size_t max_frame_size();
+  // Accepts new connections and appends every complete frame that has
+  // arrived so far, without blocking.
+  void receive(std::vector<std::vector<unsigned char> > &frames);
+  // Bytes queued but not yet written.
+  size_t pending() const;
+  // Waits up to timeout_ms until everything queued is written, reading
+  // arriving frames for the next receive() meanwhile; false on timeout.
+  // Call it before leaving, as closing drops what is still queued.
+  bool flush(int timeout_ms = 5000);
+
+private:
+  migration_node();
+  migration_node(const migration_node &) = delete;
+  migration_node &operator=(const migration_node &) = delete;
+
+  struct prv;
+  std::shared_ptr<prv> d;
+};
+
+// Forks count worker processes and runs worker(i) in the i-th, its result
+// being the exit status. Waits for all of them and returns true if every
+// worker returned 0. Meant for local runs and tests; on a cluster each
+// island is started by the job system instead.
+bool launch_workers(size_t count, const std::function<int(size_t)> &worker);
+}
+
+#endif
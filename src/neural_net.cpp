@@ -24,12 +24,69 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #include "neural_net.hpp"
 
+#include <algorithm>
+
 namespace ga4nn {
 struct neural_net::prv {
   std::vector<layer::ptr> layers;
+  std::vector<neuron::link::ptr> genes;
+  std::vector<size_t> revisions;
+  size_t links;
+
+  // Feed-forward plan for compute_batch(), empty for recurrent nets.
+  compiled_net::ptr plan;
+  std::vector<size_t> plan_revisions;
+  size_t plan_links;
+  std::vector<double> plan_weights;
 
-  prv() {}
+  prv() : links(0), plan_links(0) {}
   ~prv() {}
+
+  bool current(const std::vector<size_t> &stamp, size_t stamp_links) const {
+    bool valid = stamp.size() == layers.size()
+      && stamp_links == neuron::link_generation();
+    for (size_t i = 0; i < layers.size() && valid; ++i)
+      valid = stamp[i] == layers[i]->revision();
+    return valid;
+  }
+
+  void take_stamp(std::vector<size_t> &stamp, size_t &stamp_links) const {
+    stamp_links = neuron::link_generation();
+    stamp.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i)
+      stamp[i] = layers[i]->revision();
+  }
+
+  const std::vector<neuron::link::ptr> &gene_table() {
+    if (current(revisions, links))
+      return genes;
+
+    genes.clear();
+    take_stamp(revisions, links);
+    if (layers.size() < 2)
+      return genes;
+    for (size_t i = 0; i < layers.size(); ++i) {
+      for (size_t j = 0; j < layers[i]->neuron_count(); ++j) {
+        neuron::ptr n = layers[i]->get_neuron(j);
+        for (size_t k = 0; k < n->link_count(); ++k) {
+          neuron::link::ptr link = n->get_link(k);
+          if (!link->constant)
+            genes.push_back(link);
+        }
+      }
+    }
+    return genes;
+  }
+
+  const compiled_net::ptr &batch_plan(const neural_net &net) {
+    if (current(plan_revisions, plan_links))
+      return plan;
+    take_stamp(plan_revisions, plan_links);
+    plan = net.compile();
+    if (plan && !plan->feedforward())
+      plan.reset();
+    return plan;
+  }
 };
 
 neural_net::neural_net() : d(new prv) {}
@@ -64,6 +121,39 @@ std::vector<double> neural_net::get_weights() const {
   return weights;
 }
 
+size_t neural_net::weight_count() const { return d->gene_table().size(); }
+
+double neural_net::get_weight(size_t index) const {
+  const std::vector<neuron::link::ptr> &genes = d->gene_table();
+  if (index >= genes.size())
+    return 0.0;
+  return genes[index]->weight;
+}
+
+void neural_net::set_weight(size_t index, double value) {
+  const std::vector<neuron::link::ptr> &genes = d->gene_table();
+  if (index < genes.size())
+    genes[index]->weight = value;
+}
+
+void neural_net::set_weights_range(size_t first, const double *values,
+                                   size_t count) {
+  const std::vector<neuron::link::ptr> &genes = d->gene_table();
+  for (size_t i = 0; i < count && first + i < genes.size(); ++i)
+    genes[first + i]->weight = values[i];
+}
+
+size_t neural_net::weights_into(double *weights, size_t size) const {
+  if (d->layers.size() < 2)
+    return 0;
+  size_t count = 0;
+  for (size_t i = 0; i < d->layers.size(); ++i) {
+    size_t written = std::min(count, size);
+    count += d->layers[i]->weights_into(weights + written, size - written);
+  }
+  return count;
+}
+
 std::vector<double> neural_net::compute(const std::vector<double> &input) {
   if (d->layers.size() < 2)
     return std::vector<double>();
@@ -75,4 +165,45 @@ std::vector<double> neural_net::compute(const std::vector<double> &input) {
     d->layers[i]->compute();
   return d->layers[i - 1]->get_outputs();
 }
+
+size_t neural_net::compute_into(const double *input, size_t input_size,
+                                double *output, size_t output_size) {
+  if (d->layers.size() < 2)
+    return 0;
+  d->layers.front()->set_outputs(input, input_size);
+  for (size_t i = 0; i < d->layers.size(); ++i)
+    d->layers[i]->compute();
+  return d->layers.back()->outputs_into(output, output_size);
+}
+
+void neural_net::compute_batch(const std::vector<double> &input,
+                               std::vector<double> &output) {
+  output.clear();
+  if (d->layers.size() < 2)
+    return;
+  // Only feed-forward nets can be batched; recurrent ones keep their state
+  // in the neurons, so their rows go through compute() one by one. The
+  // plan is compiled once per topology and only handed the weights.
+  const compiled_net::ptr &c = d->batch_plan(*this);
+  if (c) {
+    d->plan_weights.resize(c->weight_count());
+    weights_into(d->plan_weights.data(), d->plan_weights.size());
+    c->bind_weights(d->plan_weights);
+    c->compute_batch(input, output);
+    return;
+  }
+  size_t inputs = d->layers.front()->neuron_count();
+  if (inputs == 0)
+    return;
+  std::vector<double> row(inputs);
+  for (size_t r = 0; r + inputs <= input.size(); r += inputs) {
+    std::copy(input.begin() + r, input.begin() + r + inputs, row.begin());
+    std::vector<double> y = compute(row);
+    std::copy(y.begin(), y.end(), std::back_inserter(output));
+  }
+}
+
+compiled_net::ptr neural_net::compile(bool optimize) const {
+  return compiled_net::compile(*this, 0.25, optimize);
+}
 }
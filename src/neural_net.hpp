@@ -27,6 +27,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <vector>
 
+#include "compiled_net.hpp"
 #include "layer.hpp"
 
 namespace ga4nn {
@@ -43,7 +44,25 @@ public:
   void set_weights(const std::vector<double> &weights);
   std::vector<double> get_weights() const;
 
+  // Single genes through a table from gene index to link, rebuilt only
+  // when a layer's topology changed or a link was created since the last
+  // call. The rebuild happens in the const readers too, so no two threads
+  // may use one net at once, even just to read it.
+  size_t weight_count() const;
+  double get_weight(size_t index) const;
+  void set_weight(size_t index, double value);
+  void set_weights_range(size_t first, const double *values, size_t count);
+  // Allocation-free forms: write at most size values into the caller's
+  // buffer and return how many there are in total.
+  size_t weights_into(double *weights, size_t size) const;
+
   std::vector<double> compute(const std::vector<double> &input);
+  size_t compute_into(const double *input, size_t input_size,
+                      double *output, size_t output_size);
+  void compute_batch(const std::vector<double> &input,
+                     std::vector<double> &output);
+
+  compiled_net::ptr compile(bool optimize = false) const;
 
 private:
   struct prv;
@@ -24,21 +24,36 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #include "neuron.hpp"
 
+#include <atomic>
 #include <cmath>
 
 namespace ga4nn {
+namespace {
+std::atomic<size_t> links_created(0);
+}
+
 neuron::~neuron() {}
 
 neuron::link::ptr neuron::create_link(neuron::ptr neuron_back,
                                       double weight,
-                                      bool constant) {
-  link::ptr l(new link(neuron_back, weight, constant));
+                                      bool constant,
+                                      const arena::ptr &a) {
+  link::ptr l = make_shared_in<link>(a, neuron_back, weight, constant);
   m_link.push_back(l);
+  links_created.fetch_add(1, std::memory_order_relaxed);
   return l;
 }
 
+void neuron::reserve_links(size_t count) {
+  m_link.reserve(m_link.size() + count);
+}
+
 size_t neuron::link_count() const { return m_link.size(); }
 
+size_t neuron::link_generation() {
+  return links_created.load(std::memory_order_relaxed);
+}
+
 neuron::link::ptr neuron::get_link(size_t index) const {
   if (index >= m_link.size())
     return link::ptr();
@@ -48,8 +63,9 @@ neuron::link::ptr neuron::get_link(size_t index) const {
 void neuron::set_weights(std::vector<double>::const_iterator &first,
                          const std::vector<double>::const_iterator &last) {
   for (size_t i = 0; (i < m_link.size()) && (first != last); ++i) {
-    if (!m_link[i]->constant)
-      m_link[i]->weight = *first;
+    if (m_link[i]->constant)
+      continue;
+    m_link[i]->weight = *first;
     ++first;
   }
 }
@@ -63,6 +79,18 @@ std::vector<double> neuron::get_weights() const {
   return weights;
 }
 
+size_t neuron::weights_into(double *weights, size_t size) const {
+  size_t count = 0;
+  for (size_t i = 0; i < m_link.size(); ++i) {
+    if (m_link[i]->constant)
+      continue;
+    if (count < size)
+      weights[count] = m_link[i]->weight;
+    ++count;
+  }
+  return count;
+}
+
 double neuron::forward() {
   double sum = 0.0;
   for (size_t i = 0; i < m_link.size(); ++i) {
@@ -78,7 +106,8 @@ struct input_neuron::prv {
   prv() : output(0.0) {}
 };
 
-input_neuron::input_neuron() : d(new prv) {}
+input_neuron::input_neuron(const arena::ptr &a) :
+  d(make_shared_in<prv>(a)) {}
 input_neuron::~input_neuron() {}
 
 bool input_neuron::activated() const { return true; }
@@ -98,7 +127,8 @@ struct sigmoid_neuron::prv {
   prv() : activated(false), output(0.0) {}
 };
 
-sigmoid_neuron::sigmoid_neuron() : d(new prv) {}
+sigmoid_neuron::sigmoid_neuron(const arena::ptr &a) :
+  d(make_shared_in<prv>(a)) {}
 sigmoid_neuron::~sigmoid_neuron() {}
 
 bool sigmoid_neuron::activated() const { return d->activated; }
@@ -127,7 +157,8 @@ struct linear_neuron::prv {
   prv() : output(0.0) {}
 };
 
-linear_neuron::linear_neuron() : d(new prv) {}
+linear_neuron::linear_neuron(const arena::ptr &a) :
+  d(make_shared_in<prv>(a)) {}
 linear_neuron::~linear_neuron() {}
 
 bool linear_neuron::activated() const { return true; }
@@ -144,27 +175,32 @@ void linear_neuron::set_output(double value) { (void)(value); }
 
 struct feedback_neuron::prv {
   std::vector<double> history;
+  size_t position;
   double output;
 
-  explicit prv(size_t hystory_len) : history(hystory_len + 1), output(0.0) {}
+  explicit prv(size_t hystory_len) :
+    history(hystory_len), position(0), output(0.0) {}
 };
 
-feedback_neuron::feedback_neuron(size_t history_len) :
-  d(new prv(history_len)) {}
+feedback_neuron::feedback_neuron(size_t history_len, const arena::ptr &a) :
+  d(make_shared_in<prv>(a, history_len)) {}
 feedback_neuron::~feedback_neuron() {}
 
+size_t feedback_neuron::history_length() const {
+  return d->history.size();
+}
+
 bool feedback_neuron::activated() const { return true; }
 
 void feedback_neuron::compute() {
   double now = forward();
-  if (d->history.size() < 2) {
+  if (d->history.empty()) {
     d->output = now;
   } else {
-    size_t len = d->history.size() - 1;
-    for (size_t i = 0; i < len; i++)
-      d->history[i] = d->history[i + 1];
-    d->history[len] = now;
-    d->output = d->history[0];
+    d->output = d->history[d->position];
+    d->history[d->position] = now;
+    if (++d->position == d->history.size())
+      d->position = 0;
   }
 }
 
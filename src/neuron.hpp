@@ -27,6 +27,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <vector>
 
+#include "arena.hpp"
+
 namespace ga4nn {
 class neuron {
 public:
@@ -49,8 +51,13 @@ public:
 
   link::ptr create_link(neuron::ptr neuron_back,
                         double weight,
-                        bool constant);
+                        bool constant,
+                        const arena::ptr &a = arena::ptr());
+  void reserve_links(size_t count);
   size_t link_count() const;
+  // Number of links ever created by any neuron, so caches of the link
+  // graph notice links added outside their layers.
+  static size_t link_generation();
   link::ptr get_link(size_t index) const;
 
   virtual bool activated() const = 0;
@@ -61,6 +68,8 @@ public:
   void set_weights(std::vector<double>::const_iterator &first,
                    const std::vector<double>::const_iterator &last);
   std::vector<double> get_weights() const;
+  // Writes up to size weights and returns how many get_weights() has.
+  size_t weights_into(double *weights, size_t size) const;
 
 protected:
   double forward();
@@ -70,7 +79,7 @@ protected:
 
 class input_neuron : public neuron {
 public:
-  input_neuron();
+  explicit input_neuron(const arena::ptr &a = arena::ptr());
   virtual ~input_neuron();
 
   virtual bool activated() const;
@@ -85,7 +94,7 @@ private:
 
 class sigmoid_neuron : public neuron {
 public:
-  sigmoid_neuron();
+  explicit sigmoid_neuron(const arena::ptr &a = arena::ptr());
   virtual ~sigmoid_neuron();
 
   virtual bool activated() const;
@@ -100,7 +109,7 @@ private:
 
 class linear_neuron : public neuron {
 public:
-  linear_neuron();
+  explicit linear_neuron(const arena::ptr &a = arena::ptr());
   virtual ~linear_neuron();
 
   virtual bool activated() const;
@@ -117,9 +126,12 @@ typedef linear_neuron output_neuron;
 
 class feedback_neuron : public neuron {
 public:
-  explicit feedback_neuron(size_t history_len);
+  explicit feedback_neuron(size_t history_len,
+                           const arena::ptr &a = arena::ptr());
   virtual ~feedback_neuron();
 
+  size_t history_length() const;
+
   virtual bool activated() const;
   virtual void compute();
   virtual double get_output() const;
@@ -27,21 +27,33 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace ga4nn {
 input_neuron_factory::input_neuron_factory() {}
 neuron::ptr input_neuron_factory::create_neuron() {
-  return neuron::ptr(new input_neuron);
+  return create_neuron(arena::ptr());
+}
+neuron::ptr input_neuron_factory::create_neuron(const arena::ptr &a) {
+  return make_shared_in<input_neuron>(a, a);
 }
 
 sigmoid_neuron_factory::sigmoid_neuron_factory() {}
 neuron::ptr sigmoid_neuron_factory::create_neuron() {
-  return neuron::ptr(new sigmoid_neuron);
+  return create_neuron(arena::ptr());
+}
+neuron::ptr sigmoid_neuron_factory::create_neuron(const arena::ptr &a) {
+  return make_shared_in<sigmoid_neuron>(a, a);
 }
 
 linear_neuron_factory::linear_neuron_factory() {}
 neuron::ptr linear_neuron_factory::create_neuron() {
-  return neuron::ptr(new linear_neuron);
+  return create_neuron(arena::ptr());
+}
+neuron::ptr linear_neuron_factory::create_neuron(const arena::ptr &a) {
+  return make_shared_in<linear_neuron>(a, a);
 }
 
 feedback_neuron_factory::feedback_neuron_factory() : m_hystory_len(1) {}
 neuron::ptr feedback_neuron_factory::create_neuron() {
-  return neuron::ptr(new feedback_neuron(m_hystory_len++));
+  return create_neuron(arena::ptr());
+}
+neuron::ptr feedback_neuron_factory::create_neuron(const arena::ptr &a) {
+  return make_shared_in<feedback_neuron>(a, m_hystory_len++, a);
 }
 }
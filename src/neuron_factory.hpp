@@ -33,18 +33,21 @@ class input_neuron_factory {
 public:
   input_neuron_factory();
   neuron::ptr create_neuron();
+  neuron::ptr create_neuron(const arena::ptr &a);
 };
 
 class sigmoid_neuron_factory {
 public:
   sigmoid_neuron_factory();
   neuron::ptr create_neuron();
+  neuron::ptr create_neuron(const arena::ptr &a);
 };
 
 class linear_neuron_factory {
 public:
   linear_neuron_factory();
   neuron::ptr create_neuron();
+  neuron::ptr create_neuron(const arena::ptr &a);
 };
 
 typedef linear_neuron_factory output_neuron_factory;
@@ -53,6 +56,7 @@ class feedback_neuron_factory {
 public:
   feedback_neuron_factory();
   neuron::ptr create_neuron();
+  neuron::ptr create_neuron(const arena::ptr &a);
 private:
   size_t m_hystory_len;
 };
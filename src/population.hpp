@@ -24,12 +24,19 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #ifndef __POPULATION_HPP
 #define __POPULATION_HPP
+#include <cmath>
 #include <cstdlib>
 
+#include <algorithm>
 #include <memory>
 #include <map>
+#include <vector>
 
 namespace ga4nn {
+// A population may also have a non-virtual swap(Population &other) that
+// exchanges all genotypes with other. The genetic runners then reuse the
+// previous generation's population instead of copying it every
+// generation.
 template<class Genotype>
 class population {
 public:
@@ -79,6 +86,9 @@ public:
   virtual void clear() {
     m_genotype.clear();
   }
+  void swap(rb_population &other) {
+    m_genotype.swap(other.m_genotype);
+  }
   virtual typename Genotype::ptr take_middle() {
     if (m_genotype.begin() == m_genotype.end())
       return typename genotype::ptr();
@@ -93,6 +103,318 @@ public:
 private:
   std::multimap<double, typename genotype::ptr> m_genotype;
 };
+
+// population kept in one contiguous vector of (fitness, genotype) pairs
+// sorted by fitness. Inserts only append; the next take_*() commits them
+// with one stable sort and a merge, so a generation's children cost a
+// single batch sort instead of a tree node each. Genotypes of equal
+// fitness come out in insertion order, exactly as from rb_population.
+template<class Genotype>
+class flat_population : public population<Genotype> {
+public:
+  typedef Genotype genotype;
+  typedef typename std::shared_ptr<flat_population> ptr;
+  flat_population() : m_first(0), m_sorted(0) {}
+  virtual ~flat_population() {}
+
+  virtual void insert(typename genotype::ptr g) {
+    m_entries.push_back(entry(g->fitness(), g));
+  }
+  virtual typename genotype::ptr take_beauty() {
+    commit();
+    if (m_first == m_entries.size())
+      return typename genotype::ptr();
+    typename genotype::ptr g = std::move(m_entries[m_first].second);
+    ++m_first;
+    return g;
+  }
+  virtual typename Genotype::ptr take_monster() {
+    commit();
+    if (m_first == m_entries.size())
+      return typename genotype::ptr();
+    typename genotype::ptr g = std::move(m_entries.back().second);
+    m_entries.pop_back();
+    --m_sorted;
+    return g;
+  }
+  virtual size_t count() const {
+    return m_entries.size() - m_first;
+  }
+  virtual void clear() {
+    m_entries.clear();
+    m_first = 0;
+    m_sorted = 0;
+  }
+  void swap(flat_population &other) {
+    m_entries.swap(other.m_entries);
+    std::swap(m_first, other.m_first);
+    std::swap(m_sorted, other.m_sorted);
+  }
+  virtual typename Genotype::ptr take_middle() {
+    commit();
+    if (m_first == m_entries.size())
+      return typename genotype::ptr();
+    typename std::vector<entry>::iterator it =
+      m_entries.begin() + m_first + count() / 2;
+    typename genotype::ptr g = std::move(it->second);
+    m_entries.erase(it);
+    --m_sorted;
+    return g;
+  }
+
+  // Sorts the genotypes inserted since the last take into place.
+  void commit() {
+    if (m_sorted == m_entries.size())
+      return;
+    if (m_first > 0) {
+      m_entries.erase(m_entries.begin(), m_entries.begin() + m_first);
+      m_sorted -= m_first;
+      m_first = 0;
+    }
+    typename std::vector<entry>::iterator middle =
+      m_entries.begin() + m_sorted;
+    std::stable_sort(middle, m_entries.end(), less);
+    std::inplace_merge(m_entries.begin(), middle, m_entries.end(), less);
+    m_sorted = m_entries.size();
+  }
+
+private:
+  typedef std::pair<double, typename genotype::ptr> entry;
+
+  static bool less(const entry &a, const entry &b) {
+    return a.first < b.first;
+  }
+
+  // Entries [m_first, m_sorted) are sorted; later ones are pending.
+  std::vector<entry> m_entries;
+  size_t m_first;
+  size_t m_sorted;
+};
+
+// Order-statistic population: a treap keyed by (fitness, insertion order)
+// with subtree sizes, its nodes kept in one vector and linked by index.
+// Besides the population interface it answers k-th, rank and percentile
+// queries and draws by rank in O(log n) without removing anything. Rank 0
+// is the beauty; equal fitness ranks in insertion order, as in
+// rb_population.
+template<class Genotype>
+class ranked_population : public population<Genotype> {
+public:
+  typedef Genotype genotype;
+  typedef typename std::shared_ptr<ranked_population> ptr;
+  ranked_population() : m_root(nil), m_serial(0), m_seed(2463534242u) {}
+  virtual ~ranked_population() {}
+
+  virtual void insert(typename genotype::ptr g) {
+    size_t n = allocate(g->fitness(), g);
+    size_t left, right;
+    split(m_root, m_node[n].fitness, m_node[n].serial, left, right);
+    m_root = merge(merge(left, n), right);
+  }
+  virtual typename genotype::ptr take_beauty() {
+    return take_kth(0);
+  }
+  virtual typename Genotype::ptr take_monster() {
+    if (m_root == nil)
+      return typename genotype::ptr();
+    return take_kth(count() - 1);
+  }
+  virtual size_t count() const {
+    return size(m_root);
+  }
+  virtual void clear() {
+    m_node.clear();
+    m_free.clear();
+    m_root = nil;
+  }
+  void swap(ranked_population &other) {
+    m_node.swap(other.m_node);
+    m_free.swap(other.m_free);
+    std::swap(m_root, other.m_root);
+    std::swap(m_serial, other.m_serial);
+    std::swap(m_seed, other.m_seed);
+  }
+  virtual typename Genotype::ptr take_middle() {
+    return take_kth(count() / 2);
+  }
+
+  // The genotype of rank k, or an empty ptr if k >= count().
+  typename genotype::ptr select_kth(size_t k) const {
+    size_t n = m_root;
+    while (n != nil) {
+      size_t left = size(m_node[n].left);
+      if (k == left)
+        return m_node[n].g;
+      if (k < left) {
+        n = m_node[n].left;
+      } else {
+        k -= left + 1;
+        n = m_node[n].right;
+      }
+    }
+    return typename genotype::ptr();
+  }
+
+  typename genotype::ptr take_kth(size_t k) {
+    if (k >= count())
+      return typename genotype::ptr();
+    size_t head, n, tail;
+    split_at(m_root, k, head, n);
+    split_at(n, 1, n, tail);
+    typename genotype::ptr g = std::move(m_node[n].g);
+    m_free.push_back(n);
+    m_root = merge(head, tail);
+    return g;
+  }
+
+  // Number of genotypes with fitness lower (better) than the given one.
+  size_t rank_of(double fitness) const {
+    size_t rank = 0;
+    size_t n = m_root;
+    while (n != nil) {
+      if (m_node[n].fitness < fitness) {
+        rank += size(m_node[n].left) + 1;
+        n = m_node[n].right;
+      } else {
+        n = m_node[n].left;
+      }
+    }
+    return rank;
+  }
+
+  // The genotype a fraction q of the way from the beauty (0) to the
+  // monster (1).
+  typename genotype::ptr percentile(double q) const {
+    return select_kth(rank_at(q));
+  }
+
+  // Linear ranking draw for u uniform in [0, 1): the beauty is picked with
+  // probability pressure / n, falling linearly to (2 - pressure) / n for
+  // the monster. pressure lies in [1, 2]; 1 draws uniformly.
+  typename genotype::ptr sample(double u, double pressure) const {
+    double x = u;
+    if (pressure > 1.0) {
+      double a = pressure - 1.0;
+      x = (pressure - std::sqrt(pressure * pressure - 4.0 * a * u)) /
+        (2.0 * a);
+    }
+    return select_kth(rank_at(x));
+  }
+
+private:
+  static const size_t nil = size_t(-1);
+
+  struct node {
+    double fitness;
+    unsigned long long serial;
+    unsigned priority;
+    size_t left;
+    size_t right;
+    size_t size;
+    typename genotype::ptr g;
+  };
+
+  size_t size(size_t n) const {
+    return n == nil ? 0 : m_node[n].size;
+  }
+
+  void update(size_t n) {
+    m_node[n].size = size(m_node[n].left) + size(m_node[n].right) + 1;
+  }
+
+  size_t rank_at(double q) const {
+    size_t n = count();
+    if (n == 0 || q <= 0.0)
+      return 0;
+    size_t k = static_cast<size_t>(q * n);
+    return k < n ? k : n - 1;
+  }
+
+  size_t allocate(double fitness, typename genotype::ptr g) {
+    size_t n;
+    if (m_free.empty()) {
+      n = m_node.size();
+      m_node.push_back(node());
+    } else {
+      n = m_free.back();
+      m_free.pop_back();
+    }
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    node &e = m_node[n];
+    e.fitness = fitness;
+    e.serial = m_serial++;
+    e.priority = m_seed;
+    e.left = nil;
+    e.right = nil;
+    e.size = 1;
+    e.g = g;
+    return n;
+  }
+
+  // Nodes ordered before (fitness, serial) go to left, the rest to right.
+  void split(size_t t, double fitness, unsigned long long serial,
+             size_t &left, size_t &right) {
+    if (t == nil) {
+      left = right = nil;
+      return;
+    }
+    node &e = m_node[t];
+    if (e.fitness < fitness || (e.fitness == fitness && e.serial < serial)) {
+      split(e.right, fitness, serial, e.right, right);
+      left = t;
+    } else {
+      split(e.left, fitness, serial, left, e.left);
+      right = t;
+    }
+    update(t);
+  }
+
+  // The first k nodes go to left, the rest to right.
+  void split_at(size_t t, size_t k, size_t &left, size_t &right) {
+    if (t == nil) {
+      left = right = nil;
+      return;
+    }
+    node &e = m_node[t];
+    size_t before = size(e.left);
+    if (k <= before) {
+      split_at(e.left, k, left, e.left);
+      right = t;
+    } else {
+      split_at(e.right, k - before - 1, e.right, right);
+      left = t;
+    }
+    update(t);
+  }
+
+  size_t merge(size_t left, size_t right) {
+    if (left == nil)
+      return right;
+    if (right == nil)
+      return left;
+    if (m_node[left].priority > m_node[right].priority) {
+      size_t n = merge(m_node[left].right, right);
+      m_node[left].right = n;
+      update(left);
+      return left;
+    }
+    size_t n = merge(left, m_node[right].left);
+    m_node[right].left = n;
+    update(right);
+    return right;
+  }
+
+  std::vector<node> m_node;
+  std::vector<size_t> m_free;
+  size_t m_root;
+  unsigned long long m_serial;
+  unsigned m_seed;
+};
+
+template<class Genotype>
+const size_t ranked_population<Genotype>::nil;
 }
 
 #endif
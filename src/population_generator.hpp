@@ -27,6 +27,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <cstdlib>
 
 #include <memory>
+#include <vector>
+
+#include "thread_pool.hpp"
 
 namespace ga4nn {
 template<class Genotype>
@@ -45,6 +48,28 @@ void fill_population( typename Population::ptr p,
   for (size_t i = 0; i < count; ++i)
     p->insert(creator->make());
 }
+
+// Calls fitness() on every genotype concurrently, so that inserting them
+// afterwards only reads cached values. Genotype::fitness() must be safe to
+// call on different genotypes at once.
+template<class Genotype>
+void evaluate_fitness(thread_pool::ptr pool,
+                      const std::vector<typename Genotype::ptr> &g) {
+  pool->run(g.size(), [&g](size_t i) { g[i]->fitness(); });
+}
+
+template<class Population, class GenotypeCreator>
+void fill_population( typename Population::ptr p,
+                      typename GenotypeCreator::ptr creator,
+                      size_t count,
+                      thread_pool::ptr pool) {
+  std::vector<typename Population::genotype::ptr> g(count);
+  for (size_t i = 0; i < count; ++i)
+    g[i] = creator->make();
+  evaluate_fitness<typename Population::genotype>(pool, g);
+  for (size_t i = 0; i < count; ++i)
+    p->insert(g[i]);
+}
 }
 
 #endif
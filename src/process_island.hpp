@@ -0,0 +1,153 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __PROCESS_ISLAND_HPP
+#define __PROCESS_ISLAND_HPP
+#include <cstdlib>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "genetic.hpp"
+#include "genome_codec.hpp"
+#include "migration_node.hpp"
+
+namespace ga4nn {
+// One island of an island model spread over processes. It evolves its
+// population like island_model does and exchanges migrants with its
+// neighbours through a migration_node as genome blocks, so only the
+// genomes and their fitness cross the process boundary; make turns a
+// received genome and its fitness back into a Genotype, which can take
+// the fitness as already computed. Genotype::get_data() must be the
+// std::vector<double> genome.
+template< class Population,
+          class Selection,
+          class Crossover,
+          class Mutation>
+class process_island {
+public:
+  typedef typename Population::genotype genotype;
+  typedef typename std::shared_ptr<process_island> ptr;
+  typedef std::function<typename genotype::ptr(const std::vector<double> &,
+                                                double)> maker;
+
+  process_island(migration_node::ptr node, size_t interval, size_t migrants,
+                 const maker &make) :
+    m_node(node),
+    m_interval(interval),
+    m_migrants(migrants),
+    m_make(make) {}
+
+  // Evolves population for generations generations and returns the
+  // number of immigrants it took in.
+  size_t run(typename Population::ptr population,
+             typename Selection::ptr selection,
+             typename Crossover::ptr crossover,
+             typename Mutation::ptr mutation,
+             size_t generations) {
+    size_t arrived = 0;
+    for (size_t gen = 1; gen <= generations; ++gen) {
+      advance_generation<Population, Selection, Crossover, Mutation>(
+        m_parents, population, selection, crossover, mutation);
+      if (m_interval != 0 && gen % m_interval == 0) {
+        emigrate(population);
+        arrived += immigrate(population);
+      }
+    }
+    return arrived;
+  }
+
+  // Sends copies of the best genotypes to every neighbour.
+  void emigrate(typename Population::ptr population) {
+    std::vector<typename genotype::ptr> best;
+    for (size_t i = 0; i < m_migrants && population->count() > 0; ++i)
+      best.push_back(population->take_beauty());
+    if (best.empty())
+      return;
+
+    // Blocks (a 16 byte header, then fitness and genes per genome) are
+    // cut to what the neighbours accept.
+    const size_t width = best[0]->get_data().size();
+    const size_t per_block = (migration_node::max_frame_size() - 16)
+      / ((width + 1) * sizeof(double));
+    for (size_t first = 0; per_block > 0 && first < best.size();
+         first += per_block) {
+      const size_t count = std::min(per_block, best.size() - first);
+      m_genes.assign(count * width, 0.0);
+      m_fitness.resize(count);
+      for (size_t i = 0; i < count; ++i) {
+        const std::vector<double> &data = best[first + i]->get_data();
+        std::copy(data.begin(), data.begin() + std::min(width, data.size()),
+                  m_genes.begin() + i * width);
+        m_fitness[i] = best[first + i]->fitness();
+      }
+      encode_genomes(m_genes, width, m_fitness, m_block);
+      m_node->send(m_block);
+    }
+    for (size_t i = 0; i < best.size(); ++i)
+      population->insert(best[i]);
+  }
+
+  // Inserts whatever has arrived, dropping the worst genotype for each
+  // immigrant; returns the number of immigrants.
+  size_t immigrate(typename Population::ptr population) {
+    m_frames.clear();
+    m_node->receive(m_frames);
+    size_t count = 0;
+    for (size_t f = 0; f < m_frames.size(); ++f) {
+      size_t width = 0;
+      if (m_frames[f].empty()
+          || !decode_genomes(&m_frames[f][0], m_frames[f].size(), m_genes,
+                             width, m_fitness))
+        continue;
+      for (size_t i = 0; i < m_fitness.size(); ++i) {
+        typename genotype::ptr g = m_make(std::vector<double>(
+          m_genes.begin() + i * width, m_genes.begin() + (i + 1) * width),
+          m_fitness[i]);
+        if (!g)
+          continue;
+        population->take_monster();
+        population->insert(g);
+        ++count;
+      }
+    }
+    return count;
+  }
+
+private:
+  migration_node::ptr m_node;
+  size_t m_interval;
+  size_t m_migrants;
+  maker m_make;
+
+  typename Population::ptr m_parents;
+  std::vector<double> m_genes;
+  std::vector<double> m_fitness;
+  std::vector<unsigned char> m_block;
+  std::vector<std::vector<unsigned char> > m_frames;
+};
+}
+
+#endif
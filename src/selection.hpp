@@ -24,7 +24,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #ifndef __SELECTION_HPP
 #define __SELECTION_HPP
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <random>
 #include <vector>
 
 namespace ga4nn {
@@ -93,6 +96,83 @@ public:
       return vec;
   }
 };
+// Draws parents with replacement from the whole generation of a
+// ranked_population, with the linear ranking pressure given (1 to 2).
+// Once as many parents as the generation held have been drawn the
+// population is cleared, so breed() moves on to the next generation.
+// The crossover must return new genotypes.
+template<class Population>
+class linear_ranking_selection : selection<Population> {
+public:
+  typedef Population population;
+  typedef typename population::genotype genotype;
+  typedef typename std::shared_ptr<linear_ranking_selection> ptr;
+
+  explicit linear_ranking_selection(double pressure = 1.5,
+                                    size_t parents = 2,
+                                    unsigned seed = 1) :
+    m_pressure(pressure), m_parents(parents), m_random(seed), m_left(0) {}
+  virtual ~linear_ranking_selection() {}
+
+  virtual std::vector<typename genotype::ptr> get_parents(
+    typename population::ptr p) {
+    if (m_left == 0)
+      m_left = p->count();
+    std::vector<typename genotype::ptr> vec(m_parents);
+    for (size_t i = 0; i < vec.size(); ++i)
+      vec[i] = p->sample(m_uniform(m_random), m_pressure);
+    m_left = m_left > m_parents ? m_left - m_parents : 0;
+    if (m_left == 0)
+      p->clear();
+    return vec;
+  }
+
+private:
+  double m_pressure;
+  size_t m_parents;
+  std::mt19937 m_random;
+  std::uniform_real_distribution<double> m_uniform;
+  size_t m_left;
+};
+
+// Like linear_ranking_selection, but draws parents uniformly from the
+// best fraction of the generation.
+template<class Population>
+class truncation_selection : selection<Population> {
+public:
+  typedef Population population;
+  typedef typename population::genotype genotype;
+  typedef typename std::shared_ptr<truncation_selection> ptr;
+
+  explicit truncation_selection(double fraction = 0.5,
+                                size_t parents = 2,
+                                unsigned seed = 1) :
+    m_fraction(fraction), m_parents(parents), m_random(seed), m_left(0) {}
+  virtual ~truncation_selection() {}
+
+  virtual std::vector<typename genotype::ptr> get_parents(
+    typename population::ptr p) {
+    if (m_left == 0)
+      m_left = p->count();
+    double kept = std::ceil(m_fraction * p->count());
+    std::vector<typename genotype::ptr> vec(m_parents);
+    for (size_t i = 0; i < vec.size(); ++i) {
+      double u = m_uniform(m_random);
+      vec[i] = p->select_kth(static_cast<size_t>(u * std::max(kept, 1.0)));
+    }
+    m_left = m_left > m_parents ? m_left - m_parents : 0;
+    if (m_left == 0)
+      p->clear();
+    return vec;
+  }
+
+private:
+  double m_fraction;
+  size_t m_parents;
+  std::mt19937 m_random;
+  std::uniform_real_distribution<double> m_uniform;
+  size_t m_left;
+};
 }
 
 #endif
@@ -0,0 +1,133 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __STATIC_NET_HPP
+#define __STATIC_NET_HPP
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include "activation.hpp"
+
+namespace ga4nn {
+template <class Hidden, class Output, size_t In, size_t... Rest>
+struct static_layers;
+
+// The last layer: In inputs, Out outputs with the output activation.
+template <class Hidden, class Output, size_t In, size_t Out>
+struct static_layers<Hidden, Output, In, Out> {
+  static const size_t weight_count = In * Out;
+  static const size_t output_count = Out;
+
+  static void forward(const double *w, const double *x, double *y) {
+    for (size_t j = 0; j < Out; ++j) {
+      double s = 0.0;
+      for (size_t k = 0; k < In; ++k)
+        s += w[j * In + k] * x[k];
+      y[j] = Output::apply(s);
+    }
+  }
+};
+
+template <class Hidden, class Output, size_t In, size_t Next,
+          size_t... Rest>
+struct static_layers<Hidden, Output, In, Next, Rest...> {
+  typedef static_layers<Hidden, Output, Next, Rest...> tail;
+  static const size_t weight_count = In * Next + tail::weight_count;
+  static const size_t output_count = tail::output_count;
+
+  static void forward(const double *w, const double *x, double *y) {
+    double h[Next];
+    for (size_t j = 0; j < Next; ++j) {
+      double s = 0.0;
+      for (size_t k = 0; k < In; ++k)
+        s += w[j * In + k] * x[k];
+      h[j] = Hidden::apply(s);
+    }
+    tail::forward(w + In * Next, h, y);
+  }
+};
+
+// Fully connected feed-forward net whose layer sizes are template
+// arguments: In inputs, then every hidden layer, then the outputs. All
+// sizes are compile-time constants, so the loops of compute() have fixed
+// trip counts the compiler can unroll, and nothing is allocated.
+//
+// The genome is the one of the equivalent neural_net built with
+// internal_connector: layer by layer, neuron by neuron, one weight per
+// neuron of the previous layer.
+template <class Hidden, class Output, size_t In, size_t... Rest>
+class basic_static_net {
+public:
+  typedef static_layers<Hidden, Output, In, Rest...> layers;
+
+  static const size_t input_count = In;
+  static const size_t output_count = layers::output_count;
+  static const size_t weight_count = layers::weight_count;
+
+  typedef std::array<double, input_count> input_type;
+  typedef std::array<double, output_count> output_type;
+
+  basic_static_net() { m_weight.fill(0.0); }
+
+  void set_weights(const std::vector<double> &weights) {
+    for (size_t i = 0; i < weight_count && i < weights.size(); ++i)
+      m_weight[i] = weights[i];
+  }
+  void set_weights(const double *weights) {
+    for (size_t i = 0; i < weight_count; ++i)
+      m_weight[i] = weights[i];
+  }
+  std::vector<double> get_weights() const {
+    return std::vector<double>(m_weight.begin(), m_weight.end());
+  }
+
+  output_type compute(const input_type &input) const {
+    output_type output;
+    layers::forward(&m_weight[0], &input[0], &output[0]);
+    return output;
+  }
+  void compute(const double *input, double *output) const {
+    layers::forward(&m_weight[0], input, output);
+  }
+
+private:
+  std::array<double, weight_count> m_weight;
+};
+
+template <class Hidden, class Output, size_t In, size_t... Rest>
+const size_t basic_static_net<Hidden, Output, In, Rest...>::input_count;
+template <class Hidden, class Output, size_t In, size_t... Rest>
+const size_t basic_static_net<Hidden, Output, In, Rest...>::output_count;
+template <class Hidden, class Output, size_t In, size_t... Rest>
+const size_t basic_static_net<Hidden, Output, In, Rest...>::weight_count;
+
+// Sigmoid hidden layers and a linear output, like a neural_net built from
+// sigmoid_neuron_factory and output_neuron_factory.
+template <size_t In, size_t... Rest>
+using static_net =
+    basic_static_net<softsign_function, identity_function, In, Rest...>;
+}
+
+#endif
@@ -0,0 +1,210 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "tangent_net.hpp"
+
+#include <algorithm>
+
+namespace ga4nn {
+namespace {
+const size_t no_block = static_cast<size_t>(-1);
+}
+
+tangent_net::tangent_net() : m_directions(0), m_stride(0) {}
+
+tangent_net::ptr tangent_net::create(const compiled_net::ptr &net,
+                                     size_t directions) {
+  if (!net || directions == 0)
+    return ptr();
+
+  ptr t(new tangent_net());
+  t->m_net = net;
+  t->m_context = net->make_context();
+  t->m_directions = directions;
+  t->m_stride = net->m_matrix.size();
+  t->m_matrix.assign(directions * t->m_stride, 0.0);
+  t->m_block.resize(directions * net->m_block.size());
+  for (size_t d = 0; d < directions; ++d)
+    for (size_t b = 0; b < net->m_block.size(); ++b)
+      t->m_block[d * net->m_block.size() + b] =
+        &t->m_matrix[d * t->m_stride + net->m_block[b].offset];
+  t->m_state.assign(directions * (net->m_outputs + net->m_history), 0.0);
+  t->m_sum.assign(directions * net->m_widest, 0.0);
+  t->m_previous.assign(directions * net->m_widest, 0.0);
+  return t;
+}
+
+size_t tangent_net::direction_count() const { return m_directions; }
+
+void tangent_net::set_weights(const std::vector<double> &weights) {
+  m_net->set_weights(*m_context, weights);
+  derive_directions();
+}
+
+std::vector<double> tangent_net::get_weights() const {
+  return m_net->get_weights(*m_context);
+}
+
+void tangent_net::set_directions(const std::vector<double> &directions) {
+  const std::vector<size_t> &gene = m_net->m_gene;
+  std::fill(m_matrix.begin(), m_matrix.end(), 0.0);
+  for (size_t d = 0; d < m_directions; ++d)
+    for (size_t g = 0; g < gene.size(); ++g)
+      if (d * gene.size() + g < directions.size())
+        m_matrix[d * m_stride + gene[g]] = directions[d * gene.size() + g];
+  derive_directions();
+}
+
+void tangent_net::seed_genes(size_t first) {
+  const std::vector<size_t> &gene = m_net->m_gene;
+  std::fill(m_matrix.begin(), m_matrix.end(), 0.0);
+  for (size_t d = 0; d < m_directions && first + d < gene.size(); ++d)
+    m_matrix[d * m_stride + gene[first + d]] = 1.0;
+  derive_directions();
+}
+
+// A fused block is base + left * right, so its change along a direction is
+// base' + left' * right + left * right'.
+void tangent_net::derive_directions() {
+  const compiled_net &net = *m_net;
+  const size_t blocks = net.m_block.size();
+  const double **value = &m_context->block[0];
+  for (size_t d = 0; d < m_directions; ++d) {
+    const double **change = &m_block[d * blocks];
+    for (size_t f = 0; f < net.m_fusion.size(); ++f) {
+      const compiled_net::fusion &fu = net.m_fusion[f];
+      const compiled_net::block &target = net.m_block[fu.target];
+      const compiled_net::block &left = net.m_block[fu.left];
+      const compiled_net::block &right = net.m_block[fu.right];
+      double *out = &m_matrix[d * m_stride + target.offset];
+      std::fill(out, out + target.entries, 0.0);
+      if (fu.base != no_block)
+        net.add_product(net.m_block[fu.base], change[fu.base], 0, 0, out);
+      net.add_product(left, change[fu.left], &right, value[fu.right], out);
+      net.add_product(left, value[fu.left], &right, change[fu.right], out);
+    }
+  }
+}
+
+void tangent_net::reset() {
+  m_net->reset(*m_context);
+  std::fill(m_state.begin(), m_state.end(), 0.0);
+}
+
+size_t tangent_net::compute(const double *input, const double *input_tangent,
+                            double *output, double *output_tangent) {
+  const compiled_net &net = *m_net;
+  const compiled_net::layer_plan &in = net.m_layer.front();
+  const compiled_net::layer_plan &out = net.m_layer.back();
+  net.load_input(*m_context, input, in.size);
+
+  double *t = &m_state[m_directions * in.offset];
+  for (size_t s = 0; s < in.spans.size(); ++s) {
+    const compiled_net::span &sp = in.spans[s];
+    if (sp.kind != compiled_net::input_activation)
+      continue;
+    for (size_t d = 0; d < m_directions; ++d)
+      for (size_t j = sp.first; j < sp.last; ++j)
+        t[d * in.size + j] = input_tangent
+          ? input_tangent[d * in.size + j] : 0.0;
+  }
+
+  for (size_t i = 0; i < net.m_layer.size(); ++i)
+    compute_layer(i);
+  ++m_context->step;
+
+  const double *y = &m_context->state[out.offset];
+  std::copy(y, y + out.size, output);
+  const double *ty = &m_state[m_directions * out.offset];
+  std::copy(ty, ty + m_directions * out.size, output_tangent);
+  return out.size;
+}
+
+// Runs the layer on the context, which leaves its sums in ctx.sum and, for
+// lateral layers, the outputs of the previous step in ctx.previous; the
+// tangents then follow the same blocks, activations and delay lines.
+void tangent_net::compute_layer(size_t index) {
+  const compiled_net &net = *m_net;
+  const compiled_net::layer_plan &l = net.m_layer[index];
+  if (!l.computed)
+    return;
+
+  compiled_net::context &ctx = *m_context;
+  double *tout = &m_state[m_directions * l.offset];
+  if (l.lateral)
+    std::copy(tout, tout + m_directions * l.size, m_previous.begin());
+  net.compute_layer(ctx, index);
+
+  const size_t width = m_directions * l.size;
+  std::fill(m_sum.begin(), m_sum.begin() + width, 0.0);
+  for (size_t b = 0; b < l.blocks.size(); ++b) {
+    const compiled_net::block &bl = l.blocks[b];
+    const compiled_net::layer_plan &source = net.m_layer[bl.source];
+    const double *tx = bl.source == index
+      ? &m_previous[0] : &m_state[m_directions * source.offset];
+    net.multiply(bl, ctx.block[bl.index], tx, m_directions, &m_sum[0]);
+    if (bl.copy)
+      continue;
+    const double *x = bl.source == index
+      ? &ctx.previous[0] : &ctx.state[source.offset];
+    for (size_t d = 0; d < m_directions; ++d)
+      net.multiply(bl, m_block[d * net.m_block.size() + bl.index], x,
+                   &m_sum[d * l.size]);
+  }
+
+  const double *z = &ctx.sum[0];
+  for (size_t s = 0; s < l.spans.size(); ++s) {
+    const compiled_net::span &sp = l.spans[s];
+    if (sp.kind == compiled_net::softsign_activation) {
+      for (size_t j = sp.first; j < sp.last; ++j) {
+        double a = 1 + (z[j] < 0 ? -z[j] : z[j]);
+        double slope = 1 / (a * a);
+        for (size_t d = 0; d < m_directions; ++d)
+          tout[d * l.size + j] = slope * m_sum[d * l.size + j];
+      }
+    } else if (sp.kind == compiled_net::linear_activation) {
+      for (size_t d = 0; d < m_directions; ++d)
+        for (size_t j = sp.first; j < sp.last; ++j)
+          tout[d * l.size + j] = m_sum[d * l.size + j];
+    }
+  }
+
+  // ctx.step has not moved yet, so this is the slot compute_layer used.
+  double *history = &m_state[m_directions * net.m_outputs];
+  for (size_t k = 0; k < l.delays.size(); ++k) {
+    const compiled_net::delay_line &dl = l.delays[k];
+    for (size_t d = 0; d < m_directions; ++d) {
+      double now = m_sum[d * l.size + dl.neuron];
+      if (dl.length == 0) {
+        tout[d * l.size + dl.neuron] = now;
+      } else {
+        double *h = &history[d * net.m_history + dl.offset
+                             + ctx.step % dl.length];
+        tout[d * l.size + dl.neuron] = *h;
+        *h = now;
+      }
+    }
+  }
+}
+}
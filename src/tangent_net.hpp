@@ -0,0 +1,91 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __TANGENT_NET_HPP
+#define __TANGENT_NET_HPP
+#include <memory>
+#include <vector>
+
+#include "compiled_net.hpp"
+
+namespace ga4nn {
+// Forward-mode differentiation of a compiled_net. Next to the outputs,
+// compute() carries direction_count() tangents: the derivatives of every
+// output along fixed directions in weight space, including the part that
+// flows in through the inputs (as in a closed control loop) and through
+// feedback delays. One rollout thus yields exact directional derivatives;
+// seeding the directions with genes gives the gradient in
+// weight_count() / direction_count() rollouts instead of one per gene.
+class tangent_net {
+public:
+  typedef std::shared_ptr<tangent_net> ptr;
+
+  static ptr create(const compiled_net::ptr &net, size_t directions);
+
+  size_t direction_count() const;
+
+  void set_weights(const std::vector<double> &weights);
+  std::vector<double> get_weights() const;
+  // directions x weight_count() values, row-major.
+  void set_directions(const std::vector<double> &directions);
+  // Direction d becomes the unit vector of gene first + d, or zero past
+  // the last gene.
+  void seed_genes(size_t first);
+
+  // Clears outputs, histories and their tangents.
+  void reset();
+  // input has input_count() values and input_tangent, which may be null
+  // for inputs independent of the weights, directions x input_count().
+  // Writes output_count() outputs and directions x output_count()
+  // tangents and returns output_count(). Never allocates.
+  size_t compute(const double *input, const double *input_tangent,
+                 double *output, double *output_tangent);
+
+private:
+  tangent_net();
+  tangent_net(const tangent_net &) = delete;
+  tangent_net &operator=(const tangent_net &) = delete;
+
+  void derive_directions();
+  void compute_layer(size_t index);
+
+  compiled_net::ptr m_net;
+  compiled_net::context::ptr m_context;
+  size_t m_directions;
+  size_t m_stride;
+
+  // Per direction, the weight change laid out like the context's matrix,
+  // and the block pointers into it.
+  std::vector<double> m_matrix;
+  std::vector<const double *> m_block;
+
+  // Layer l's tangents live at state[directions * l.offset], directions x
+  // l.size; the histories follow all layers, directions x history each.
+  std::vector<double> m_state;
+  std::vector<double> m_sum;
+  std::vector<double> m_previous;
+};
+}
+
+#endif
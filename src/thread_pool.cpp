@@ -0,0 +1,202 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "thread_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ga4nn {
+namespace {
+struct job {
+  std::function<void()> task;
+  std::atomic<size_t> *pending;
+};
+
+struct job_queue {
+  std::mutex mutex;
+  std::deque<job> jobs;
+};
+
+void split(task_group &g, size_t first, size_t last,
+           const std::function<void(size_t)> &task) {
+  while (last - first > 1) {
+    size_t mid = first + (last - first) / 2;
+    g.spawn([&g, mid, last, &task] { split(g, mid, last, task); });
+    last = mid;
+  }
+  if (first < last)
+    task(first);
+}
+}
+
+struct thread_pool::prv {
+  std::vector<std::thread> workers;
+  // One deque per worker, then the one shared by outside threads.
+  std::vector<std::shared_ptr<job_queue> > queues;
+  std::atomic<size_t> queued;
+
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::atomic<size_t> sleepers;
+  bool stop;
+
+  static thread_local prv *current;
+  static thread_local size_t current_index;
+
+  prv() : queued(0), sleepers(0), stop(false) {}
+
+  size_t home() const {
+    return current == this ? current_index : queues.size() - 1;
+  }
+
+  void push(job &&j) {
+    job_queue &q = *queues[home()];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.jobs.push_back(std::move(j));
+    }
+    ++queued;
+    if (sleepers > 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      wake.notify_one();
+    }
+  }
+
+  // The newest job of the own deque, or else the oldest one of another.
+  bool pop(job &j) {
+    if (queued == 0)
+      return false;
+    const size_t h = home();
+    for (size_t k = 0; k < queues.size(); ++k) {
+      job_queue &q = *queues[(h + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.jobs.empty())
+        continue;
+      if (k == 0) {
+        j = std::move(q.jobs.back());
+        q.jobs.pop_back();
+      } else {
+        j = std::move(q.jobs.front());
+        q.jobs.pop_front();
+      }
+      --queued;
+      return true;
+    }
+    return false;
+  }
+
+  // The last job of a group wakes its waiter, which may be parked.
+  void execute(job &j) {
+    j.task();
+    j.task = nullptr;
+    if (--*j.pending == 0 && sleepers > 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      wake.notify_all();
+    }
+  }
+
+  void loop(size_t index) {
+    current = this;
+    current_index = index;
+    job j;
+    for (;;) {
+      if (pop(j)) {
+        execute(j);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      ++sleepers;
+      wake.wait(lock, [this] { return stop || queued > 0; });
+      --sleepers;
+      if (stop)
+        return;
+    }
+  }
+};
+
+thread_local thread_pool::prv *thread_pool::prv::current = 0;
+thread_local size_t thread_pool::prv::current_index = 0;
+
+thread_pool::thread_pool(size_t threads) : d(new prv) {
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  for (size_t i = 0; i < threads; ++i)
+    d->queues.push_back(std::shared_ptr<job_queue>(new job_queue));
+  for (size_t i = 0; i + 1 < threads; ++i)
+    d->workers.push_back(std::thread(&prv::loop, d.get(), i));
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lock(d->sleep_mutex);
+    d->stop = true;
+  }
+  d->wake.notify_all();
+  for (size_t i = 0; i < d->workers.size(); ++i)
+    d->workers[i].join();
+}
+
+size_t thread_pool::thread_count() const { return d->workers.size() + 1; }
+
+void thread_pool::run(size_t count, const std::function<void(size_t)> &task) {
+  task_group g(*this);
+  split(g, 0, count, task);
+  g.wait();
+}
+
+task_group::task_group(thread_pool &pool) : m_pool(pool), m_pending(0) {}
+
+task_group::~task_group() { wait(); }
+
+void task_group::spawn(std::function<void()> task) {
+  ++m_pending;
+  job j;
+  j.task = std::move(task);
+  j.pending = &m_pending;
+  m_pool.d->push(std::move(j));
+}
+
+// Runs queued jobs while there are any; with nothing left to steal it
+// sleeps until a job is queued or the group's last one finishes.
+void task_group::wait() {
+  thread_pool::prv &p = *m_pool.d;
+  job j;
+  while (m_pending > 0) {
+    if (p.pop(j)) {
+      p.execute(j);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(p.sleep_mutex);
+    ++p.sleepers;
+    p.wake.wait(lock, [&] { return m_pending == 0 || p.queued > 0; });
+    --p.sleepers;
+  }
+}
+}
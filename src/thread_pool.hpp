@@ -0,0 +1,87 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __THREAD_POOL_HPP
+#define __THREAD_POOL_HPP
+#include <cstdlib>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace ga4nn {
+class task_group;
+
+// Work-stealing scheduler. Every worker keeps its own deque of tasks: it
+// pushes and pops at the back, so nested tasks run depth-first while they
+// are hot in cache, and idle workers steal from the front of the others'
+// deques, taking the oldest and usually largest pieces of work. Threads
+// outside the pool share one more deque. Tasks may spawn tasks and wait
+// for them; a waiting thread keeps running queued tasks meanwhile.
+class thread_pool {
+public:
+  typedef std::shared_ptr<thread_pool> ptr;
+  // Zero picks the number of hardware threads. The thread waiting on a
+  // task_group works as well, so a pool of n threads starts n - 1 workers.
+  explicit thread_pool(size_t threads = 0);
+  virtual ~thread_pool();
+
+  size_t thread_count() const;
+
+  // Calls task(i) once for every i in [0, count) and returns when all
+  // calls are done. The range is split in halves recursively, so idle
+  // threads steal large parts of it; run() may be called from a task.
+  void run(size_t count, const std::function<void(size_t)> &task);
+
+private:
+  friend class task_group;
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  struct prv;
+  std::shared_ptr<prv> d;
+};
+
+// Tasks spawned together and waited for together.
+class task_group {
+public:
+  explicit task_group(thread_pool &pool);
+  // Waits for the tasks still running.
+  virtual ~task_group();
+
+  void spawn(std::function<void()> task);
+  // Returns once every spawned task, including those spawned while
+  // waiting, has finished.
+  void wait();
+
+private:
+  task_group(const task_group &) = delete;
+  task_group &operator=(const task_group &) = delete;
+
+  thread_pool &m_pool;
+  std::atomic<size_t> m_pending;
+};
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "typed_layer.hpp"
+
+namespace ga4nn {
+typed_layer_base::typed_layer_base(size_t size) : m_output(size, 0.0) {}
+typed_layer_base::~typed_layer_base() {}
+
+size_t typed_layer_base::neuron_count() const { return m_output.size(); }
+
+const std::vector<double> &typed_layer_base::get_outputs() const {
+  return m_output;
+}
+
+void typed_layer_base::set_outputs(
+    std::vector<double>::const_iterator &first,
+    const std::vector<double>::const_iterator &last) {
+  for (size_t i = 0; (i < m_output.size()) && (first != last); ++i) {
+    m_output[i] = *first;
+    ++first;
+  }
+}
+}
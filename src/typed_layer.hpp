@@ -0,0 +1,165 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef __TYPED_LAYER_HPP
+#define __TYPED_LAYER_HPP
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "activation.hpp"
+
+namespace ga4nn {
+// Common part of all typed layers: the outputs and the weight interface
+// used by typed_net. Neurons are not objects here, only rows of a layer.
+class typed_layer_base {
+public:
+  typedef typename std::shared_ptr<typed_layer_base> ptr;
+  virtual ~typed_layer_base();
+
+  size_t neuron_count() const;
+  const std::vector<double> &get_outputs() const;
+  void set_outputs(std::vector<double>::const_iterator &first,
+                   const std::vector<double>::const_iterator &last);
+
+  virtual size_t weight_count() const = 0;
+  virtual void set_weights(std::vector<double>::const_iterator &first,
+                           const std::vector<double>::const_iterator &last) = 0;
+  virtual std::vector<double> get_weights() const = 0;
+  virtual void compute() = 0;
+
+protected:
+  explicit typed_layer_base(size_t size);
+
+  std::vector<double> m_output;
+};
+
+// A layer of neurons that all share the Activation policy. The links of
+// every source layer are kept as one dense row-major matrix, so compute()
+// is a plain multiply-accumulate loop with the activation inlined.
+//
+// Weights are ordered like those of an equivalent layer: neuron by neuron,
+// links in the order they were connected, constant links skipped. All
+// links, including links to this layer itself, read the outputs of the
+// previous compute(). A layer without connections keeps the outputs set on
+// it, which is how inputs are fed.
+template <class Activation>
+class typed_layer : public typed_layer_base {
+public:
+  typedef typename std::shared_ptr<typed_layer> ptr;
+
+  explicit typed_layer(size_t size) :
+    typed_layer_base(size), m_link(size), m_sum(size), m_lateral(false) {}
+
+  // l_back must outlive this layer.
+  template <class Connector>
+  void connect_back(const typed_layer_base::ptr &l_back, Connector connector) {
+    block b = { l_back.get(), l_back->neuron_count(), m_weight.size() };
+    m_weight.resize(m_weight.size() + m_output.size() * b.cols, 0.0);
+    for (size_t i = 0; i < m_output.size(); ++i) {
+      for (size_t j = 0; j < b.cols; ++j) {
+        if (!connector.valid_connection(j, i))
+          continue;
+        link l = { b.offset + i * b.cols + j, connector.constant() };
+        m_weight[l.offset] = connector.weight();
+        m_link[i].push_back(l);
+      }
+    }
+    m_block.push_back(b);
+    if (b.source == this)
+      m_lateral = true;
+
+    m_gene.clear();
+    for (size_t i = 0; i < m_link.size(); ++i)
+      for (size_t k = 0; k < m_link[i].size(); ++k)
+        if (!m_link[i][k].constant)
+          m_gene.push_back(m_link[i][k].offset);
+  }
+
+  virtual size_t weight_count() const { return m_gene.size(); }
+
+  virtual void set_weights(std::vector<double>::const_iterator &first,
+                           const std::vector<double>::const_iterator &last) {
+    for (size_t g = 0; g < m_gene.size() && first != last; ++g) {
+      m_weight[m_gene[g]] = *first;
+      ++first;
+    }
+  }
+
+  virtual std::vector<double> get_weights() const {
+    std::vector<double> weights(m_gene.size());
+    for (size_t g = 0; g < m_gene.size(); ++g)
+      weights[g] = m_weight[m_gene[g]];
+    return weights;
+  }
+
+  virtual void compute() {
+    if (m_block.empty())
+      return;
+    if (m_lateral)
+      m_previous = m_output;
+    std::fill(m_sum.begin(), m_sum.end(), 0.0);
+    for (size_t b = 0; b < m_block.size(); ++b) {
+      const block &bl = m_block[b];
+      const double *x = bl.source == this
+        ? &m_previous[0]
+        : &bl.source->get_outputs()[0];
+      const double *w = &m_weight[bl.offset];
+      for (size_t r = 0; r < m_sum.size(); ++r, w += bl.cols) {
+        double s = 0.0;
+        for (size_t c = 0; c < bl.cols; ++c)
+          s += w[c] * x[c];
+        m_sum[r] += s;
+      }
+    }
+    for (size_t r = 0; r < m_sum.size(); ++r)
+      m_output[r] = Activation::apply(m_sum[r]);
+  }
+
+private:
+  struct block {
+    const typed_layer_base *source;
+    size_t cols;
+    size_t offset;
+  };
+
+  struct link {
+    size_t offset;
+    bool constant;
+  };
+
+  std::vector<block> m_block;
+  std::vector<std::vector<link> > m_link;
+  std::vector<size_t> m_gene;
+  std::vector<double> m_weight;
+  std::vector<double> m_sum;
+  std::vector<double> m_previous;
+  bool m_lateral;
+};
+
+typedef typed_layer<softsign_function> softsign_layer;
+typedef typed_layer<identity_function> identity_layer;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+COPYRIGHT (c) 2017 Mikhail Pimenov
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "typed_net.hpp"
+
+namespace ga4nn {
+struct typed_net::prv {
+  std::vector<typed_layer_base::ptr> layers;
+
+  prv() {}
+  ~prv() {}
+};
+
+typed_net::typed_net() : d(new prv) {}
+typed_net::~typed_net() {}
+
+void typed_net::add_layer(typed_layer_base::ptr l) { d->layers.push_back(l); }
+
+size_t typed_net::layer_count() const { return d->layers.size(); }
+
+typed_layer_base::ptr typed_net::get_layer(size_t index) const {
+  if (index >= d->layers.size())
+    return typed_layer_base::ptr();
+  return d->layers[index];
+}
+
+size_t typed_net::weight_count() const {
+  size_t count = 0;
+  for (size_t i = 0; i < d->layers.size(); ++i)
+    count += d->layers[i]->weight_count();
+  return count;
+}
+
+void typed_net::set_weights(const std::vector<double> &weights) {
+  std::vector<double>::const_iterator first = weights.begin();
+  std::vector<double>::const_iterator last = weights.end();
+  for (size_t i = 0; i < d->layers.size() && first != last; ++i)
+    d->layers[i]->set_weights(first, last);
+}
+
+std::vector<double> typed_net::get_weights() const {
+  std::vector<double> weights;
+  for (size_t i = 0; i < d->layers.size(); ++i) {
+    std::vector<double> layer_weights = d->layers[i]->get_weights();
+    weights.insert(weights.end(), layer_weights.begin(), layer_weights.end());
+  }
+  return weights;
+}
+
+std::vector<double> typed_net::compute(const std::vector<double> &input) {
+  if (d->layers.size() < 2)
+    return std::vector<double>();
+  std::vector<double>::const_iterator first = input.begin();
+  std::vector<double>::const_iterator last = input.end();
+  d->layers.front()->set_outputs(first, last);
+  for (size_t i = 0; i < d->layers.size(); ++i)
+    d->layers[i]->compute();
+  return d->layers.back()->get_outputs();
+}
+}
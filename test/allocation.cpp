@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+// Built into its own test executable: replacing the global allocation
+// functions here must not change how the rest of the tests allocate.
+namespace {
+std::atomic<size_t> allocations(0);
+
+void *counted_malloc(size_t size) {
+  ++allocations;
+  return std::malloc(size ? size : 1);
+}
+
+// Kept out of line: once a delete is inlined next to a standard library
+// new, GCC takes the pair for mismatched and warns about the free().
+__attribute__((noinline)) void release(void *p) { std::free(p); }
+}
+
+void *operator new(size_t size) {
+  if (void *p = counted_malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+  if (void *p = counted_malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return counted_malloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return counted_malloc(size);
+}
+
+void operator delete(void *p) noexcept { release(p); }
+
+void operator delete[](void *p) noexcept { release(p); }
+
+void operator delete(void *p, size_t) noexcept { release(p); }
+
+void operator delete[](void *p, size_t) noexcept { release(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  release(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  release(p);
+}
+
+#ifdef __cpp_aligned_new
+namespace {
+void *counted_aligned(size_t size, std::align_val_t alignment) {
+  ++allocations;
+  size_t a = std::max(static_cast<size_t>(alignment), sizeof(void *));
+  void *p = 0;
+  if (posix_memalign(&p, a, size ? size : 1) != 0)
+    return 0;
+  return p;
+}
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  if (void *p = counted_aligned(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+  if (void *p = counted_aligned(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+  release(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+  release(p);
+}
+#endif
+
+TEST(allocation, compute_into_does_not_allocate) {
+  neural_net::ptr net = make_feedback_net(2, 4, 1);
+  compiled_net::ptr compiled = net->compile();
+  compiled_net::context::ptr ctx = compiled->make_context();
+  std::vector<double> weights(compiled->weight_count(), 0.1);
+  net->set_weights(weights);
+  compiled->set_weights(*ctx, weights);
+
+  double input[2] = { 0.5, -0.25 };
+  double expected[1];
+  double actual[1];
+  double genome[64];
+  size_t before = allocations;
+  for (size_t step = 0; step < 100; ++step) {
+    input[0] = -input[0];
+    EXPECT_EQ(1u, net->compute_into(input, 2, expected, 1));
+    EXPECT_EQ(1u, compiled->compute_into(*ctx, input, 2, actual, 1));
+    EXPECT_DOUBLE_EQ(expected[0], actual[0]);
+  }
+  EXPECT_EQ(weights.size(), net->weights_into(genome, 64));
+  EXPECT_EQ(weights.size(), compiled->weights_into(*ctx, genome, 64));
+  EXPECT_EQ(before, allocations);
+  EXPECT_EQ(weights, std::vector<double>(genome, genome + weights.size()));
+}
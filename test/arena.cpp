@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "arena.hpp"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+TEST(arena, allocations_are_aligned_and_packed) {
+  arena a(1024);
+  for (size_t i = 0; i < 100; ++i) {
+    size_t alignment = size_t(1) << (i % 5);
+    void *p = a.allocate(i % 7 + 1, alignment);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(p) % alignment);
+  }
+  EXPECT_EQ(1u, a.block_count());
+  a.allocate(4096, 8);
+  EXPECT_EQ(2u, a.block_count());
+}
+
+TEST(arena, net_in_arena_matches_heap_net) {
+  arena::ptr a(new arena);
+  neural_net::ptr pooled = make_feedback_net(20, 30, 5, a);
+  neural_net::ptr heap = make_feedback_net(20, 30, 5);
+  EXPECT_GT(a->bytes_allocated(), 0u);
+
+  std::vector<double> weights = heap->get_weights();
+  for (size_t i = 0; i < weights.size(); ++i)
+    weights[i] = 2.0 * std::rand() / RAND_MAX - 1.0;
+  heap->set_weights(weights);
+  pooled->set_weights(weights);
+  EXPECT_EQ(weights, pooled->get_weights());
+
+  for (size_t step = 0; step < 10; ++step) {
+    std::vector<double> input(20);
+    for (size_t i = 0; i < input.size(); ++i)
+      input[i] = 2.0 * std::rand() / RAND_MAX - 1.0;
+    EXPECT_EQ(heap->compute(input), pooled->compute(input));
+  }
+}
+
+TEST(arena, objects_keep_their_arena_alive) {
+  arena::ptr a(new arena), b(new arena);
+  layer::ptr input_layer(new layer(a));
+  input_layer->add_neurons(input_neuron_factory(), 4);
+  layer::ptr output_layer(new layer(b));
+  output_layer->add_neurons(output_neuron_factory(), 3);
+  output_layer->connect_back(input_layer, internal_connector());
+
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(output_layer);
+  neuron::ptr kept = input_layer->get_neuron(0);
+  std::vector<double> output = net->compute(std::vector<double>(4, 1.0));
+  ASSERT_EQ(3u, output.size());
+
+  // The links in the second arena release neurons of the first after the
+  // first layer and both arenas' last outside owners are gone.
+  input_layer.reset();
+  output_layer.reset();
+  a.reset();
+  b.reset();
+  net.reset();
+  kept->set_output(0.5);
+  EXPECT_EQ(0.5, kept->get_output());
+}
@@ -0,0 +1,444 @@
+#include <cstdlib>
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+
+#include "mock_neuron.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+TEST(compiled_net, weights_follow_neural_net_layout) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(2, 5, 1);
+  std::vector<double> weights = random_vector(net->get_weights().size());
+  net->set_weights(weights);
+
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_EQ(2, c->input_count());
+  EXPECT_EQ(1, c->output_count());
+  EXPECT_EQ(weights.size(), c->weight_count());
+  EXPECT_EQ(weights, c->get_weights());
+}
+
+TEST(compiled_net, compute_matches_neural_net) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(2, 5, 1);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+
+  for (size_t g = 0; g < 10; ++g) {
+    std::vector<double> weights = random_vector(c->weight_count());
+    net->set_weights(weights);
+    c->set_weights(weights);
+    for (size_t s = 0; s < 4; ++s) {
+      std::vector<double> input = random_vector(2);
+      std::vector<double> expected = net->compute(input);
+      std::vector<double> actual = c->compute(input);
+      ASSERT_EQ(expected.size(), actual.size());
+      EXPECT_NEAR(expected[0], actual[0], 1e-12);
+    }
+  }
+}
+
+TEST(compiled_net, feedback_state_matches_neural_net) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+
+  std::vector<double> weights = random_vector(net->get_weights().size());
+  EXPECT_EQ(weights.size(), c->weight_count());
+  net->set_weights(weights);
+  c->set_weights(weights);
+  for (size_t step = 0; step < 20; ++step) {
+    std::vector<double> input = random_vector(2);
+    std::vector<double> expected = net->compute(input);
+    std::vector<double> actual = c->compute(input);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-12);
+  }
+}
+
+TEST(compiled_net, unknown_neuron_is_not_compiled) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 1);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(output_neuron_factory(), 1);
+  output_layer->get_neuron(0)->create_link(neuron::ptr(new mock_neuron),
+                                           1.0, false);
+
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(output_layer);
+  EXPECT_FALSE(net->compile());
+}
+
+TEST(compiled_net, compute_batch_matches_compute) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(3, 7, 2);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_TRUE(c->feedforward());
+  c->set_weights(random_vector(c->weight_count()));
+
+  const size_t rows = 11;
+  std::vector<double> input = random_vector(rows * 3);
+  std::vector<double> output;
+  c->compute_batch(input, output);
+  ASSERT_EQ(rows * 2, output.size());
+  for (size_t r = 0; r < rows; ++r) {
+    std::vector<double> row(input.begin() + r * 3, input.begin() + r * 3 + 3);
+    std::vector<double> expected = c->compute(row);
+    EXPECT_NEAR(expected[0], output[r * 2], 1e-12);
+    EXPECT_NEAR(expected[1], output[r * 2 + 1], 1e-12);
+  }
+}
+
+// The net keeps its batch plan across calls but must follow weight and
+// topology changes.
+TEST(compiled_net, net_compute_batch_follows_changes) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(3, 7, 2);
+  const size_t rows = 5;
+  std::vector<double> input = random_vector(rows * 3);
+  std::vector<double> output;
+  for (size_t round = 0; round < 3; ++round) {
+    if (round == 2) {
+      layer::ptr extra(new layer);
+      extra->add_neurons(output_neuron_factory(), 1);
+      extra->connect_back(net->get_layer(2), internal_connector());
+      net->add_layer(extra);
+    }
+    net->set_weights(random_vector(net->weight_count()));
+    net->compute_batch(input, output);
+    size_t outputs = round == 2 ? 1 : 2;
+    ASSERT_EQ(rows * outputs, output.size());
+    for (size_t r = 0; r < rows; ++r) {
+      std::vector<double> row(input.begin() + r * 3,
+                              input.begin() + r * 3 + 3);
+      std::vector<double> expected = net->compute(row);
+      for (size_t o = 0; o < outputs; ++o)
+        EXPECT_NEAR(expected[o], output[r * outputs + o], 1e-12);
+    }
+  }
+}
+
+TEST(compiled_net, recurrent_compute_batch_runs_rows_in_order) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_FALSE(c->feedforward());
+  std::vector<double> weights = random_vector(c->weight_count());
+  net->set_weights(weights);
+  c->set_weights(weights);
+
+  std::vector<double> input = random_vector(8 * 2);
+  std::vector<double> expected;
+  net->compute_batch(input, expected);
+  std::vector<double> actual;
+  c->compute_batch(input, actual);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+    EXPECT_NEAR(expected[i], actual[i], 1e-12);
+}
+
+TEST(compiled_net, compute_population_matches_compute_batch) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(3, 6, 2);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  std::vector<double> own = random_vector(c->weight_count());
+  c->set_weights(own);
+
+  const size_t genomes = 37;
+  const size_t samples = 70;
+  std::vector<double> weights = random_vector(genomes * c->weight_count());
+  std::vector<double> input = random_vector(samples * 3);
+  std::vector<double> output;
+  c->compute_population(weights, input, output);
+  ASSERT_EQ(genomes * samples * 2, output.size());
+  EXPECT_EQ(own, c->get_weights());
+
+  for (size_t g = 0; g < genomes; ++g) {
+    c->set_weights(std::vector<double>(
+        weights.begin() + g * c->weight_count(),
+        weights.begin() + (g + 1) * c->weight_count()));
+    std::vector<double> expected;
+    c->compute_batch(input, expected);
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], output[g * samples * 2 + i], 1e-12);
+  }
+}
+
+TEST(compiled_net, bind_weights_reads_genome_in_place) {
+  neural_net::ptr net = make_net<linear_neuron_factory>(2, 4, 1);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_TRUE(c->all_direct());
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  std::vector<double> input = random_vector(2);
+  c->set_weights(genome);
+  std::vector<double> copied = c->compute(input);
+
+  std::vector<double> other = random_vector(c->weight_count());
+  EXPECT_TRUE(c->bind_weights(other));
+  EXPECT_TRUE(c->bind_weights(genome));
+  EXPECT_EQ(genome, c->get_weights());
+  EXPECT_FALSE(c->bind_weights(random_vector(c->weight_count() - 1)));
+  EXPECT_FALSE(c->bind_weights(random_vector(c->weight_count() + 1)));
+  EXPECT_EQ(genome, c->get_weights());
+  EXPECT_EQ(copied, c->compute(input));
+
+  genome[0] += 1.0;
+  net->set_weights(genome);
+  EXPECT_NEAR(net->compute(input)[0], c->compute(input)[0], 1e-12);
+}
+
+TEST(compiled_net, bind_weights_scatters_blocks_with_constants) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_FALSE(c->all_direct());
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  net->set_weights(genome);
+  c->bind_weights(genome);
+  EXPECT_EQ(genome, c->get_weights());
+  for (size_t step = 0; step < 10; ++step) {
+    std::vector<double> input = random_vector(2);
+    std::vector<double> expected = net->compute(input);
+    std::vector<double> actual = c->compute(input);
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-12);
+  }
+}
+
+TEST(compiled_net, set_weights_does_not_read_a_freed_binding) {
+  neural_net::ptr net = make_net<linear_neuron_factory>(2, 4, 1);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  std::vector<double> *bound =
+    new std::vector<double>(random_vector(c->weight_count()));
+  c->bind_weights(*bound);
+  delete bound;
+  c->set_weights(genome);
+  EXPECT_EQ(genome, c->get_weights());
+
+  // A partial write keeps the other genes of the bound genome.
+  std::vector<double> other = random_vector(c->weight_count());
+  c->bind_weights(other);
+  c->set_weights_range(1, &genome[1], 2);
+  std::vector<double> expected = other;
+  expected[1] = genome[1];
+  expected[2] = genome[2];
+  EXPECT_EQ(expected, c->get_weights());
+}
+
+TEST(compiled_net, contexts_run_concurrently) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+
+  const size_t workers = 4;
+  const size_t steps = 200;
+  std::vector<std::vector<double> > genome(workers);
+  std::vector<std::vector<double> > expected(workers);
+  std::vector<double> input = random_vector(steps * 2);
+  for (size_t w = 0; w < workers; ++w) {
+    genome[w] = random_vector(c->weight_count());
+    compiled_net::context::ptr ctx = c->make_context();
+    c->set_weights(*ctx, genome[w]);
+    c->compute_batch(*ctx, input, expected[w]);
+  }
+
+  std::vector<std::vector<double> > actual(workers);
+  std::vector<std::thread> threads;
+  for (size_t w = 0; w < workers; ++w)
+    threads.push_back(std::thread([&, w]() {
+      compiled_net::context::ptr ctx = c->make_context();
+      c->bind_weights(*ctx, genome[w]);
+      for (size_t s = 0; s < steps; ++s) {
+        std::vector<double> y = c->compute(
+            *ctx, std::vector<double>(input.begin() + s * 2,
+                                      input.begin() + s * 2 + 2));
+        actual[w].insert(actual[w].end(), y.begin(), y.end());
+      }
+    }));
+  for (size_t w = 0; w < workers; ++w)
+    threads[w].join();
+
+  for (size_t w = 0; w < workers; ++w)
+    EXPECT_EQ(expected[w], actual[w]);
+}
+
+TEST(compiled_net, restore_state_replays_rollout) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  c->set_weights(random_vector(c->weight_count()));
+
+  for (size_t step = 0; step < 7; ++step)
+    c->compute(random_vector(2));
+  compiled_net::snapshot saved;
+  c->save_state(saved);
+
+  std::vector<std::vector<double> > input(12);
+  std::vector<std::vector<double> > expected(input.size());
+  for (size_t step = 0; step < input.size(); ++step) {
+    input[step] = random_vector(2);
+    expected[step] = c->compute(input[step]);
+  }
+
+  EXPECT_TRUE(c->restore_state(saved));
+  for (size_t step = 0; step < input.size(); ++step)
+    EXPECT_EQ(expected[step], c->compute(input[step]));
+
+  compiled_net::snapshot other;
+  make_net<sigmoid_neuron_factory>(2, 3, 1)->compile()->save_state(other);
+  EXPECT_FALSE(c->restore_state(other));
+}
+
+TEST(compiled_net, sparse_blocks_match_dense_blocks) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 40);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), 30);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(output_neuron_factory(), 3);
+  hidden_layer->connect_back(input_layer, banded_connector(2, 3));
+  output_layer->connect_back(hidden_layer, internal_connector());
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(output_layer);
+
+  compiled_net::ptr sparse = compiled_net::compile(*net);
+  compiled_net::ptr dense = compiled_net::compile(*net, 0.0);
+  ASSERT_TRUE(sparse);
+  ASSERT_TRUE(dense);
+  EXPECT_TRUE(sparse->get_layer(1).blocks[0].sparse);
+  EXPECT_FALSE(sparse->get_layer(2).blocks[0].sparse);
+  EXPECT_FALSE(dense->get_layer(1).blocks[0].sparse);
+  EXPECT_EQ(dense->get_weights(), sparse->get_weights());
+
+  std::vector<double> weights = random_vector(sparse->weight_count());
+  net->set_weights(weights);
+  sparse->set_weights(weights);
+  std::vector<double> input = random_vector(40);
+  std::vector<double> expected = net->compute(input);
+  std::vector<double> actual = sparse->compute(input);
+  for (size_t i = 0; i < expected.size(); ++i)
+    EXPECT_NEAR(expected[i], actual[i], 1e-12);
+
+  std::vector<double> genomes = random_vector(5 * sparse->weight_count());
+  std::vector<double> rows = random_vector(9 * 40);
+  std::vector<double> from_sparse, from_dense;
+  sparse->compute_population(genomes, rows, from_sparse);
+  dense->compute_population(genomes, rows, from_dense);
+  ASSERT_EQ(from_dense.size(), from_sparse.size());
+  for (size_t i = 0; i < from_dense.size(); ++i)
+    EXPECT_NEAR(from_dense[i], from_sparse[i], 1e-12);
+}
+
+TEST(compiled_net, optimize_fuses_linear_layers) {
+  neural_net::ptr net = make_net<linear_neuron_factory>(3, 5, 2);
+  compiled_net::ptr plain = net->compile();
+  compiled_net::ptr fused = net->compile(true);
+  ASSERT_TRUE(fused);
+  EXPECT_FALSE(fused->get_layer(1).computed);
+  ASSERT_EQ(1u, fused->get_layer(2).blocks.size());
+  EXPECT_EQ(0u, fused->get_layer(2).blocks[0].source);
+  EXPECT_EQ(plain->weight_count(), fused->weight_count());
+
+  std::vector<double> genome = random_vector(fused->weight_count());
+  plain->set_weights(genome);
+  fused->bind_weights(genome);
+  EXPECT_EQ(genome, fused->get_weights());
+  std::vector<double> input = random_vector(3);
+  std::vector<double> expected = plain->compute(input);
+  std::vector<double> actual = fused->compute(input);
+  for (size_t i = 0; i < expected.size(); ++i)
+    EXPECT_NEAR(expected[i], actual[i], 1e-12);
+
+  std::vector<double> genomes = random_vector(4 * fused->weight_count());
+  std::vector<double> rows = random_vector(6 * 3);
+  std::vector<double> from_plain, from_fused;
+  plain->compute_population(genomes, rows, from_plain);
+  fused->compute_population(genomes, rows, from_fused);
+  ASSERT_EQ(from_plain.size(), from_fused.size());
+  for (size_t i = 0; i < from_plain.size(); ++i)
+    EXPECT_NEAR(from_plain[i], from_fused[i], 1e-12);
+}
+
+TEST(compiled_net, optimize_folds_constants_and_dead_layers) {
+  neural_net::ptr net = make_feedback_net();
+  layer::ptr unused(new layer);
+  unused->add_neurons(sigmoid_neuron_factory(), 4);
+  unused->connect_back(net->get_layer(1), internal_connector());
+  neural_net::ptr wider(new neural_net);
+  wider->add_layer(net->get_layer(0));
+  wider->add_layer(net->get_layer(1));
+  wider->add_layer(net->get_layer(2));
+  wider->add_layer(unused);
+  wider->add_layer(net->get_layer(3));
+
+  compiled_net::ptr c = wider->compile(true);
+  ASSERT_TRUE(c);
+  EXPECT_TRUE(c->get_layer(2).blocks[0].copy);
+  EXPECT_FALSE(c->get_layer(3).computed);
+  EXPECT_TRUE(c->get_layer(3).blocks.empty());
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  wider->set_weights(genome);
+  c->set_weights(genome);
+  for (size_t step = 0; step < 10; ++step) {
+    std::vector<double> input = random_vector(2);
+    std::vector<double> expected = wider->compute(input);
+    std::vector<double> actual = c->compute(input);
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-12);
+  }
+}
+
+TEST(compiled_net, set_weight_updates_single_genes) {
+  neural_net::ptr net = make_feedback_net();
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_EQ(net->get_weights().size(), net->weight_count());
+  EXPECT_EQ(c->weight_count(), net->weight_count());
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  net->set_weights(genome);
+  c->bind_weights(genome);
+  std::vector<double> changed = genome;
+  changed[3] = 0.75;
+  changed[7] = -0.5;
+  changed[8] = 0.125;
+  net->set_weight(3, 0.75);
+  net->set_weights_range(7, &changed[7], 2);
+  c->set_weight(3, 0.75);
+  c->set_weights_range(7, &changed[7], 2);
+  EXPECT_EQ(changed, net->get_weights());
+  EXPECT_EQ(changed, c->get_weights());
+  EXPECT_EQ(0.75, net->get_weight(3));
+  EXPECT_NE(0.75, genome[3]);
+
+  layer::ptr extra(new layer);
+  extra->add_neurons(output_neuron_factory(), 1);
+  extra->connect_back(net->get_layer(3), internal_connector());
+  net->add_layer(extra);
+  EXPECT_EQ(changed.size() + 2, net->weight_count());
+  net->set_weight(changed.size() + 1, 2.0);
+  EXPECT_EQ(2.0, net->get_weights().back());
+
+  // Links made directly on a neuron are seen as well.
+  neuron::ptr back = net->get_layer(0)->get_neuron(0);
+  extra->get_neuron(0)->create_link(back, 0.5, false);
+  EXPECT_EQ(changed.size() + 3, net->weight_count());
+  EXPECT_EQ(0.5, net->get_weight(changed.size() + 2));
+}
@@ -0,0 +1,66 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "layer.hpp"
+#include "neuron_factory.hpp"
+
+using namespace ga4nn;
+
+namespace {
+// Hides the row interface so layer::connect_back() checks every pair.
+template <class Connector>
+class pairwise {
+public:
+  explicit pairwise(const Connector &c) : m_connector(c) {}
+  bool valid_connection(size_t back_index, size_t front_index) {
+    return m_connector.valid_connection(back_index, front_index);
+  }
+  double weight() { return m_connector.weight(); }
+  bool constant() { return m_connector.constant(); }
+
+private:
+  Connector m_connector;
+};
+
+template <class Connector>
+void expect_same_links(Connector connector, size_t backs, size_t fronts) {
+  layer::ptr back(new layer);
+  back->add_neurons(input_neuron_factory(), backs);
+  layer::ptr bulk(new layer);
+  bulk->add_neurons(sigmoid_neuron_factory(), fronts);
+  layer::ptr pairs(new layer);
+  pairs->add_neurons(sigmoid_neuron_factory(), fronts);
+
+  bulk->connect_back(back, connector);
+  pairs->connect_back(back, pairwise<Connector>(connector));
+  EXPECT_EQ(connector.connection_count(backs, fronts),
+            bulk->connection_count());
+  ASSERT_EQ(pairs->connection_count(), bulk->connection_count());
+  for (size_t i = 0; i < fronts; ++i) {
+    neuron::ptr a = bulk->get_neuron(i);
+    neuron::ptr b = pairs->get_neuron(i);
+    ASSERT_EQ(b->link_count(), a->link_count());
+    for (size_t k = 0; k < a->link_count(); ++k) {
+      EXPECT_EQ(b->get_link(k)->neuron_back, a->get_link(k)->neuron_back);
+      EXPECT_EQ(b->get_link(k)->weight, a->get_link(k)->weight);
+      EXPECT_EQ(b->get_link(k)->constant, a->get_link(k)->constant);
+    }
+  }
+}
+}
+
+TEST(connector, rows_match_valid_connection) {
+  expect_same_links(dense_connector(0.25), 7, 5);
+  expect_same_links(diagonal_connector(1.0, true), 7, 5);
+  expect_same_links(diagonal_connector(), 4, 9);
+  expect_same_links(banded_connector(1, 2), 9, 9);
+  expect_same_links(banded_connector(0, 0, 0.5), 3, 8);
+  expect_same_links(block_connector(3, 2), 10, 9);
+
+  std::vector<size_t> offset = { 0, 2, 2, 5 };
+  std::vector<size_t> index = { 1, 4, 0, 2, 6 };
+  expect_same_links(csr_connector(offset, index), 5, 4);
+  expect_same_links(feedback_connector(), 6, 6);
+  expect_same_links(internal_connector(), 3, 4);
+}
@@ -69,3 +69,16 @@ TEST(sigmoid_neuron, compute) {
 
   EXPECT_EQ(n->activated(), output > 0.5);
 }
+
+TEST(feedback_neuron, delays_input_by_history_length) {
+  neuron::ptr source(new input_neuron);
+  std::shared_ptr<feedback_neuron> f(new feedback_neuron(3));
+  f->create_link(source, 1.0, true);
+
+  EXPECT_EQ(3, f->history_length());
+  for (int step = 1; step <= 10; ++step) {
+    source->set_output(step);
+    f->compute();
+    EXPECT_DOUBLE_EQ(step > 3 ? step - 3 : 0.0, f->get_output());
+  }
+}
@@ -0,0 +1,321 @@
+#include <cstdlib>
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "genetic.hpp"
+#include "thread_pool.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class test_genotype : public genotype<std::vector<double> > {
+public:
+  typedef std::shared_ptr<test_genotype> ptr;
+  explicit test_genotype(const std::vector<double> &data) :
+    genotype<std::vector<double> >(data), m_computed(false), m_fitval(0.0) {}
+
+  virtual double fitness() {
+    if (m_computed)
+      return m_fitval;
+    m_fitval = 0.0;
+    for (size_t i = 0; i < m_data.size(); ++i)
+      m_fitval += (m_data[i] - 0.3) * (m_data[i] - 0.3);
+    m_computed = true;
+    return m_fitval;
+  }
+
+private:
+  bool m_computed;
+  double m_fitval;
+};
+
+class test_creator : public genotype_creator<test_genotype> {
+public:
+  typedef std::shared_ptr<test_creator> ptr;
+  test_creator() : m_seed(1) {}
+  test_genotype::ptr make() {
+    std::vector<double> data(6);
+    for (size_t i = 0; i < data.size(); ++i) {
+      m_seed = m_seed * 1103515245 + 12345;
+      data[i] = (m_seed >> 16) % 2001 / 1000.0 - 1.0;
+    }
+    return test_genotype::ptr(new test_genotype(data));
+  }
+
+private:
+  unsigned m_seed;
+};
+
+typedef rb_population<test_genotype> test_population;
+typedef bb_selection<test_population> test_selection;
+
+class test_crossover : public crossover<test_genotype> {
+public:
+  typedef std::shared_ptr<test_crossover> ptr;
+  virtual std::vector<test_genotype::ptr> cross(
+    const std::vector<test_genotype::ptr> &p) {
+    std::vector<test_genotype::ptr> children;
+    for (size_t c = 0; c < p.size(); ++c) {
+      if (!p[c])
+        continue;
+      std::vector<double> data = p[c]->get_data();
+      const test_genotype::ptr &other = p[p.size() - 1 - c];
+      for (size_t i = 0; other && i < data.size(); ++i)
+        data[i] = 0.75 * data[i] + 0.25 * other->get_data()[i];
+      children.push_back(test_genotype::ptr(new test_genotype(data)));
+    }
+    return children;
+  }
+};
+
+class test_mutation : public mutation<test_genotype> {
+public:
+  typedef std::shared_ptr<test_mutation> ptr;
+  test_mutation() : m_count(0) {}
+  virtual test_genotype::ptr mutate(test_genotype::ptr g) {
+    ++m_count;
+    g->get_data()[m_count % g->get_data().size()] += 0.01 * (m_count % 7);
+    return g;
+  }
+
+private:
+  size_t m_count;
+};
+
+// Depends on the genotype only, so it may run concurrently. The child
+// may already have been scored, so the result is a new genotype.
+class shrink_mutation : public mutation<test_genotype> {
+public:
+  typedef std::shared_ptr<shrink_mutation> ptr;
+  virtual test_genotype::ptr mutate(test_genotype::ptr g) {
+    std::vector<double> data = g->get_data();
+    data[static_cast<size_t>(data[0] * 1000 + 1000) % data.size()] *= 0.9;
+    return test_genotype::ptr(new test_genotype(data));
+  }
+};
+
+// Scores its children on the pool from within a pool task.
+class nested_crossover : public test_crossover {
+public:
+  typedef std::shared_ptr<nested_crossover> ptr;
+  explicit nested_crossover(thread_pool::ptr pool) : m_pool(pool) {}
+  virtual std::vector<test_genotype::ptr> cross(
+    const std::vector<test_genotype::ptr> &p) {
+    std::vector<test_genotype::ptr> children = test_crossover::cross(p);
+    if (m_pool)
+      m_pool->run(children.size(), [&children](size_t i) {
+        children[i]->fitness();
+      });
+    return children;
+  }
+
+private:
+  thread_pool::ptr m_pool;
+};
+
+class test_stop : public stop_function<test_population> {
+public:
+  typedef std::shared_ptr<test_stop> ptr;
+  explicit test_stop(size_t epochs) : m_epochs(epochs) {}
+  virtual bool done(test_population::ptr) { return m_epochs-- == 0; }
+
+private:
+  size_t m_epochs;
+};
+
+std::vector<std::vector<double> > run(thread_pool::ptr pool) {
+  test_population::ptr population(new test_population);
+  test_creator::ptr creator(new test_creator);
+  if (pool)
+    fill_population<test_population, test_creator>(population, creator, 64,
+                                                     pool);
+  else
+    fill_population<test_population, test_creator>(population, creator, 64);
+
+  test_selection::ptr selection(new test_selection);
+  test_crossover::ptr cross(new test_crossover);
+  test_mutation::ptr mutate(new test_mutation);
+  test_stop::ptr stop(new test_stop(10));
+  test_population::ptr result = pool
+    ? evolve<test_population, test_selection, test_crossover, test_mutation,
+             test_stop>(population, selection, cross, mutate, stop, pool)
+    : evolve<test_population, test_selection, test_crossover, test_mutation,
+             test_stop>(population, selection, cross, mutate, stop);
+
+  std::vector<std::vector<double> > ranked;
+  while (result->count() > 0)
+    ranked.push_back(result->take_beauty()->get_data());
+  return ranked;
+}
+
+std::vector<std::vector<double> > run_concurrent(thread_pool::ptr pool) {
+  test_population::ptr population(new test_population);
+  test_creator::ptr creator(new test_creator);
+  fill_population<test_population, test_creator>(population, creator, 64);
+  test_selection::ptr selection(new test_selection);
+  nested_crossover::ptr cross(new nested_crossover(pool));
+  shrink_mutation::ptr mutate(new shrink_mutation);
+  test_stop::ptr stop(new test_stop(10));
+  test_population::ptr result = pool
+    ? evolve<test_population, test_selection, nested_crossover,
+             shrink_mutation, test_stop>(population, selection, cross,
+                                         mutate, stop, pool, true)
+    : evolve<test_population, test_selection, nested_crossover,
+             shrink_mutation, test_stop>(population, selection, cross,
+                                         mutate, stop);
+
+  std::vector<std::vector<double> > ranked;
+  while (result->count() > 0)
+    ranked.push_back(result->take_beauty()->get_data());
+  return ranked;
+}
+
+// Counts its copies, to check evolve() swaps generations instead.
+class counted_population : public rb_population<test_genotype> {
+public:
+  typedef std::shared_ptr<counted_population> ptr;
+  static size_t copies;
+  counted_population() {}
+  counted_population(const counted_population &other) :
+    rb_population<test_genotype>(other) { ++copies; }
+};
+size_t counted_population::copies = 0;
+
+class counted_stop : public stop_function<counted_population> {
+public:
+  typedef std::shared_ptr<counted_stop> ptr;
+  explicit counted_stop(size_t epochs) : m_epochs(epochs) {}
+  virtual bool done(counted_population::ptr) { return m_epochs-- == 0; }
+
+private:
+  size_t m_epochs;
+};
+
+// Only the population interface, without swap().
+class plain_population : public population<test_genotype> {
+public:
+  typedef std::shared_ptr<plain_population> ptr;
+  static size_t copies;
+  plain_population() {}
+  plain_population(const plain_population &other) :
+    m_genotype(other.m_genotype) { ++copies; }
+
+  virtual void insert(test_genotype::ptr g) { m_genotype.insert(g); }
+  virtual test_genotype::ptr take_beauty() { return m_genotype.take_beauty(); }
+  virtual test_genotype::ptr take_monster() {
+    return m_genotype.take_monster();
+  }
+  virtual size_t count() const { return m_genotype.count(); }
+  virtual void clear() { m_genotype.clear(); }
+
+private:
+  test_population m_genotype;
+};
+size_t plain_population::copies = 0;
+
+class plain_stop : public stop_function<plain_population> {
+public:
+  typedef std::shared_ptr<plain_stop> ptr;
+  explicit plain_stop(size_t epochs) : m_epochs(epochs) {}
+  virtual bool done(plain_population::ptr) { return m_epochs-- == 0; }
+
+private:
+  size_t m_epochs;
+};
+
+// Every task waits for the two tasks it spawned.
+size_t count_leaves(thread_pool &pool, size_t depth) {
+  if (depth == 0)
+    return 1;
+  size_t left = 0, right = 0;
+  task_group g(pool);
+  g.spawn([&] { left = count_leaves(pool, depth - 1); });
+  g.spawn([&] { right = count_leaves(pool, depth - 1); });
+  g.wait();
+  return left + right;
+}
+}
+
+TEST(thread_pool, runs_every_index_once) {
+  thread_pool pool(4);
+  EXPECT_EQ(4u, pool.thread_count());
+  for (size_t round = 0; round < 20; ++round) {
+    std::vector<std::atomic<int> > hits(100 + round);
+    for (size_t i = 0; i < hits.size(); ++i)
+      hits[i] = 0;
+    pool.run(hits.size(), [&hits](size_t i) { ++hits[i]; });
+    for (size_t i = 0; i < hits.size(); ++i)
+      EXPECT_EQ(1, hits[i]);
+  }
+}
+
+TEST(thread_pool, nested_tasks_are_waited_for) {
+  thread_pool pool(4);
+  EXPECT_EQ(1024u, count_leaves(pool, 10));
+
+  std::atomic<size_t> calls(0);
+  pool.run(8, [&](size_t) {
+    pool.run(16, [&](size_t) { ++calls; });
+  });
+  EXPECT_EQ(128u, calls.load());
+}
+
+TEST(thread_pool, single_thread_runs_tasks_on_the_waiter) {
+  thread_pool pool(1);
+  EXPECT_EQ(1u, pool.thread_count());
+  EXPECT_EQ(64u, count_leaves(pool, 6));
+}
+
+TEST(evolve, parallel_generation_matches_serial) {
+  std::vector<std::vector<double> > serial = run(thread_pool::ptr());
+  std::vector<std::vector<double> > parallel =
+    run(thread_pool::ptr(new thread_pool(4)));
+  ASSERT_EQ(64u, serial.size());
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST(evolve, concurrent_operators_match_serial) {
+  std::vector<std::vector<double> > serial = run_concurrent(thread_pool::ptr());
+  std::vector<std::vector<double> > parallel =
+    run_concurrent(thread_pool::ptr(new thread_pool(4)));
+  ASSERT_EQ(64u, serial.size());
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST(evolve, generations_are_swapped_not_copied) {
+  typedef bb_selection<counted_population> selection_type;
+  counted_population::ptr population(new counted_population);
+  test_creator::ptr creator(new test_creator);
+  fill_population<counted_population, test_creator>(population, creator, 32);
+  counted_population::copies = 0;
+  counted_population::ptr result =
+    evolve<counted_population, selection_type, test_crossover,
+           test_mutation, counted_stop>(
+      population, selection_type::ptr(new selection_type),
+      test_crossover::ptr(new test_crossover),
+      test_mutation::ptr(new test_mutation),
+      counted_stop::ptr(new counted_stop(20)));
+  EXPECT_EQ(32u, result->count());
+  EXPECT_EQ(32u, population->count());
+  // One copy of the initial population to breed from, one for the spare.
+  EXPECT_EQ(2u, counted_population::copies);
+}
+
+TEST(evolve, populations_without_swap_are_copied) {
+  typedef bb_selection<plain_population> selection_type;
+  plain_population::ptr population(new plain_population);
+  test_creator::ptr creator(new test_creator);
+  fill_population<plain_population, test_creator>(population, creator, 32);
+  plain_population::copies = 0;
+  plain_population::ptr result =
+    evolve<plain_population, selection_type, test_crossover,
+           test_mutation, plain_stop>(
+      population, selection_type::ptr(new selection_type),
+      test_crossover::ptr(new test_crossover),
+      test_mutation::ptr(new test_mutation),
+      plain_stop::ptr(new plain_stop(20)));
+  EXPECT_EQ(32u, result->count());
+  EXPECT_EQ(21u, plain_population::copies);
+}
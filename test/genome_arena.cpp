@@ -0,0 +1,256 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "arena_genotype.hpp"
+#include "genetic.hpp"
+#include "genome_arena.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class sphere_genotype : public arena_genotype {
+public:
+  typedef std::shared_ptr<sphere_genotype> ptr;
+  explicit sphere_genotype(genome_arena &arena) : arena_genotype(arena) {}
+
+  static size_t evaluations;
+
+protected:
+  virtual double evaluate() {
+    ++evaluations;
+    double f = 0.0;
+    for (size_t i = 0; i < size(); ++i)
+      f += (genes()[i] - 0.3) * (genes()[i] - 0.3);
+    return f;
+  }
+};
+size_t sphere_genotype::evaluations = 0;
+
+class sphere_creator : public genotype_creator<sphere_genotype> {
+public:
+  typedef std::shared_ptr<sphere_creator> ptr;
+  explicit sphere_creator(genome_arena::ptr arena) :
+    m_arena(arena), m_seed(1) {}
+  sphere_genotype::ptr make() {
+    sphere_genotype::ptr g(new sphere_genotype(*m_arena));
+    for (size_t i = 0; i < g->size(); ++i) {
+      m_seed = m_seed * 1103515245 + 12345;
+      g->genes()[i] = (m_seed >> 16) % 2001 / 1000.0 - 1.0;
+    }
+    return g;
+  }
+
+private:
+  genome_arena::ptr m_arena;
+  unsigned m_seed;
+};
+
+class sphere_population : public arena_population<sphere_genotype> {
+public:
+  typedef std::shared_ptr<sphere_population> ptr;
+  explicit sphere_population(const genome_arena::ptr &arena) :
+    arena_population<sphere_genotype>(arena) {}
+};
+
+typedef bb_selection<sphere_population> sphere_selection;
+
+class sphere_crossover : public crossover<sphere_genotype> {
+public:
+  typedef std::shared_ptr<sphere_crossover> ptr;
+  virtual std::vector<sphere_genotype::ptr> cross(
+    const std::vector<sphere_genotype::ptr> &p) {
+    std::vector<sphere_genotype::ptr> children;
+    for (size_t c = 0; c < p.size(); ++c) {
+      if (!p[c])
+        continue;
+      sphere_genotype::ptr child(new sphere_genotype(*p[c]));
+      const sphere_genotype::ptr &other = p[p.size() - 1 - c];
+      for (size_t i = 0; other && i < child->size(); ++i)
+        child->genes()[i] = 0.75 * child->genes()[i]
+          + 0.25 * other->genes()[i];
+      child->reset();
+      children.push_back(child);
+    }
+    return children;
+  }
+};
+
+class sphere_mutation : public mutation<sphere_genotype> {
+public:
+  typedef std::shared_ptr<sphere_mutation> ptr;
+  virtual sphere_genotype::ptr mutate(sphere_genotype::ptr g) { return g; }
+};
+
+class sphere_stop : public stop_function<sphere_population> {
+public:
+  typedef std::shared_ptr<sphere_stop> ptr;
+  explicit sphere_stop(size_t epochs) : m_epochs(epochs) {}
+  virtual bool done(sphere_population::ptr) { return m_epochs-- == 0; }
+
+private:
+  size_t m_epochs;
+};
+}
+
+TEST(genome_arena, create) {
+  EXPECT_FALSE(genome_arena::create(0, 4));
+  EXPECT_FALSE(genome_arena::create(4, 0));
+  EXPECT_FALSE(genome_arena::create(size_t(-1) / 2, 16));
+
+  genome_arena::ptr a = genome_arena::create(5, 13);
+  ASSERT_TRUE(a);
+  EXPECT_EQ(13u, a->genes());
+  EXPECT_EQ(16u, a->stride());
+  EXPECT_EQ(0u, a->parents());
+  for (size_t g = 0; g < 2; ++g) {
+    EXPECT_EQ(5u, a->capacity(g));
+    EXPECT_EQ(0u, a->count(g));
+  }
+}
+
+TEST(genome_arena, rows_are_aligned) {
+  genome_arena::ptr a = genome_arena::create(3, 5);
+  ASSERT_TRUE(a);
+  for (size_t i = 0; i < 7; ++i) {
+    genome_arena::slot s = a->add_child();
+    EXPECT_EQ(1u, s.generation);
+    EXPECT_EQ(i, s.index);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(a->genome(s)) % 64);
+  }
+  EXPECT_EQ(12u, a->capacity(1));
+  EXPECT_EQ(3u, a->capacity(0));
+}
+
+TEST(genome_arena, swap_exchanges_generations) {
+  genome_arena::ptr a = genome_arena::create(2, 3);
+  ASSERT_TRUE(a);
+  std::vector<genome_arena::slot> slots;
+  for (size_t i = 0; i < 4; ++i) {
+    genome_arena::slot s = a->add_child();
+    for (size_t g = 0; g < 3; ++g)
+      a->genome(s)[g] = 10.0 * i + g;
+    if (i % 2 == 0)
+      a->set_fitness(s, i * 0.5);
+    slots.push_back(s);
+  }
+  // Growing kept the rows written before.
+  EXPECT_EQ(4u, a->capacity(1));
+  EXPECT_EQ(1.0, a->genome(slots[0])[1]);
+  EXPECT_EQ(genome_arena::scored, a->flags(slots[2]));
+  EXPECT_EQ(0u, a->flags(slots[1]));
+  const double *first = a->genome(slots[0]);
+
+  a->swap();
+  EXPECT_EQ(1u, a->parents());
+  EXPECT_EQ(4u, a->count(1));
+  EXPECT_EQ(0u, a->count(0));
+  EXPECT_EQ(first, a->genome(slots[0]));
+  EXPECT_EQ(32.0, a->genome(slots[3])[2]);
+  EXPECT_EQ(1.0, a->fitness(slots[2]));
+
+  // Children from the parents go to the other generation.
+  std::vector<genome_arena::slot> children;
+  for (size_t i = 0; i < 4; ++i) {
+    genome_arena::slot s = a->add_child();
+    EXPECT_EQ(0u, s.generation);
+    EXPECT_EQ(0.0, a->genome(s)[1]);
+    EXPECT_EQ(0u, a->flags(s));
+    for (size_t g = 0; g < 3; ++g)
+      a->genome(s)[g] = a->genome(slots[3 - i])[g] + 1.0;
+    a->set_flags(s, 2);
+    children.push_back(s);
+  }
+  a->swap();
+  EXPECT_EQ(0u, a->parents());
+  EXPECT_EQ(31.0, a->genome(children[0])[0]);
+  EXPECT_EQ(2u, a->flags(children[0]));
+
+  // The former parents' rows are reused, zeroed.
+  genome_arena::slot s = a->add_child();
+  EXPECT_EQ(first, a->genome(s));
+  EXPECT_EQ(0.0, a->genome(s)[1]);
+  EXPECT_EQ(1u, a->count(1));
+
+  a->clear();
+  EXPECT_EQ(0u, a->count(0));
+  EXPECT_EQ(0u, a->count(1));
+}
+
+TEST(genome_arena, reused_rows_invalidate_old_slots) {
+  genome_arena::ptr a = genome_arena::create(2, 3);
+  ASSERT_TRUE(a);
+  genome_arena::slot old = a->add_child();
+  EXPECT_TRUE(a->valid(old));
+  a->swap();
+  EXPECT_TRUE(a->valid(old));
+  a->add_child();
+  a->swap();
+  EXPECT_FALSE(a->valid(old));
+  genome_arena::slot reused = a->add_child();
+  EXPECT_EQ(old.generation, reused.generation);
+  EXPECT_EQ(old.index, reused.index);
+  EXPECT_TRUE(a->valid(reused));
+  EXPECT_FALSE(a->valid(old));
+  EXPECT_DEBUG_DEATH(a->genome(old), "");
+
+  a->clear();
+  EXPECT_FALSE(a->valid(reused));
+}
+
+TEST(arena_genotype, copies_genes_and_fitness) {
+  genome_arena::ptr a = genome_arena::create(4, 3);
+  sphere_creator creator(a);
+  sphere_genotype::evaluations = 0;
+  sphere_genotype::ptr g = creator.make();
+  double f = g->fitness();
+  EXPECT_EQ(f, g->fitness());
+  EXPECT_EQ(1u, sphere_genotype::evaluations);
+
+  sphere_genotype copy(*g);
+  EXPECT_NE(g->genes(), copy.genes());
+  for (size_t i = 0; i < 3; ++i)
+    EXPECT_EQ(g->genes()[i], copy.genes()[i]);
+  EXPECT_EQ(f, copy.fitness());
+  EXPECT_EQ(1u, sphere_genotype::evaluations);
+
+  copy.genes()[0] = 0.3;
+  copy.reset();
+  EXPECT_NE(f, copy.fitness());
+  EXPECT_EQ(2u, sphere_genotype::evaluations);
+}
+
+TEST(arena_genotype, evolve_reuses_two_generations) {
+  const size_t size = 32;
+  genome_arena::ptr a = genome_arena::create(size, 6);
+  sphere_population::ptr population(new sphere_population(a));
+  fill_population<sphere_population, sphere_creator>(
+    population, sphere_creator::ptr(new sphere_creator(a)), size);
+  sphere_genotype::ptr first = population->take_beauty();
+  double initial = first->fitness();
+  population->insert(first);
+
+  sphere_population::ptr result =
+    evolve<sphere_population, sphere_selection, sphere_crossover,
+           sphere_mutation, sphere_stop>(
+      population, sphere_selection::ptr(new sphere_selection),
+      sphere_crossover::ptr(new sphere_crossover),
+      sphere_mutation::ptr(new sphere_mutation),
+      sphere_stop::ptr(new sphere_stop(20)));
+
+  ASSERT_EQ(size, result->count());
+  EXPECT_EQ(size, a->capacity(0));
+  EXPECT_EQ(size, a->capacity(1));
+  EXPECT_EQ(size, a->count(1 - a->parents()));
+  sphere_genotype::ptr best = result->take_beauty();
+  EXPECT_LE(best->fitness(), initial);
+  double f = best->fitness();
+  best->reset();
+  EXPECT_EQ(f, best->fitness());
+
+  // The seeds' rows went to later generations.
+  EXPECT_TRUE(best->valid());
+  EXPECT_FALSE(first->valid());
+}
@@ -0,0 +1,115 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "genotype.hpp"
+#include "gradient_mutation.hpp"
+#include "gradient_net.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+double loss(const compiled_net::ptr &c, const std::vector<double> &weights,
+            const std::vector<double> &input,
+            const std::vector<double> &target) {
+  compiled_net::context::ptr ctx = c->make_context();
+  c->set_weights(*ctx, weights);
+  std::vector<double> output;
+  c->compute_batch(*ctx, input, output);
+  double sum = 0.0;
+  for (size_t i = 0; i < output.size(); ++i)
+    sum += (output[i] - target[i]) * (output[i] - target[i]);
+  return sum;
+}
+
+void expect_gradient_matches(const compiled_net::ptr &c, size_t rows) {
+  ASSERT_TRUE(c);
+  gradient_net::ptr g = gradient_net::create(c);
+  ASSERT_TRUE(g);
+  std::vector<double> weights = random_vector(c->weight_count());
+  std::vector<double> input = random_vector(rows * c->input_count());
+  std::vector<double> target = random_vector(rows * c->output_count());
+
+  std::vector<double> gradient;
+  double value = g->loss_gradient(weights, input, target, gradient);
+  EXPECT_NEAR(loss(c, weights, input, target), value, 1e-12);
+  ASSERT_EQ(weights.size(), gradient.size());
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < weights.size(); ++i) {
+    std::vector<double> up = weights, down = weights;
+    up[i] += h;
+    down[i] -= h;
+    double expected = (loss(c, up, input, target)
+                       - loss(c, down, input, target)) / (2 * h);
+    EXPECT_NEAR(expected, gradient[i], 1e-6);
+  }
+}
+
+class test_genotype : public genotype<std::vector<double> > {
+public:
+  typedef std::shared_ptr<test_genotype> ptr;
+  explicit test_genotype(const std::vector<double> &weights) :
+    genotype<std::vector<double> >(weights) {}
+  virtual double fitness() { return 0.0; }
+};
+}
+
+TEST(gradient_net, gradient_matches_differences) {
+  expect_gradient_matches(make_net<sigmoid_neuron_factory>(3, 5, 2)
+                          ->compile(), 6);
+}
+
+TEST(gradient_net, sparse_blocks_are_differentiated) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 40);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), 12);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(output_neuron_factory(), 2);
+  hidden_layer->connect_back(input_layer, banded_connector(2, 3));
+  output_layer->connect_back(hidden_layer, internal_connector());
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(output_layer);
+
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c->get_layer(1).blocks[0].sparse);
+  expect_gradient_matches(c, 3);
+}
+
+TEST(gradient_net, fused_blocks_are_differentiated) {
+  compiled_net::ptr c =
+    make_net<linear_neuron_factory, sigmoid_neuron_factory>(3, 4, 2)
+    ->compile(true);
+  ASSERT_FALSE(c->get_layer(1).computed);
+  expect_gradient_matches(c, 5);
+}
+
+TEST(gradient_net, feedback_is_differentiated_through_time) {
+  compiled_net::ptr c = make_feedback_net()->compile();
+  ASSERT_FALSE(c->feedforward());
+  expect_gradient_matches(c, 7);
+}
+
+TEST(gradient_net, gradient_mutation_lowers_the_error) {
+  compiled_net::ptr c = make_net<sigmoid_neuron_factory>(2, 5, 1)->compile();
+  double xor_input[] = {0, 0, 0, 1, 1, 1, 1, 0};
+  double xor_target[] = {0, 1, 0, 1};
+  std::vector<double> input(xor_input, xor_input + 8);
+  std::vector<double> target(xor_target, xor_target + 4);
+
+  gradient_mutation<test_genotype> refine(gradient_net::create(c), input,
+                                          target, 50, 0.5);
+  test_genotype::ptr g(new test_genotype(random_vector(c->weight_count())));
+  double before = loss(c, g->get_data(), input, target);
+  test_genotype::ptr refined = refine.mutate(g);
+  EXPECT_EQ(g, refined);
+  EXPECT_LT(loss(c, refined->get_data(), input, target), before);
+}
@@ -0,0 +1,132 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "incremental_net.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+neural_net::ptr make_banded_net(size_t inputs, size_t hidden,
+                                size_t outputs, bool banded) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), inputs);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), hidden);
+  layer::ptr second_layer(new layer);
+  second_layer->add_neurons(sigmoid_neuron_factory(), hidden);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(output_neuron_factory(), outputs);
+  if (banded)
+    hidden_layer->connect_back(input_layer, banded_connector(2, 3));
+  else
+    hidden_layer->connect_back(input_layer, internal_connector());
+  second_layer->connect_back(hidden_layer, internal_connector());
+  output_layer->connect_back(second_layer, internal_connector());
+
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(second_layer);
+  net->add_layer(output_layer);
+  return net;
+}
+
+void expect_changes_match(const compiled_net::ptr &c) {
+  std::vector<double> input = random_vector(7 * c->input_count());
+  incremental_net::ptr inc = incremental_net::create(c, input);
+  ASSERT_TRUE(inc);
+  EXPECT_EQ(7u, inc->sample_count());
+
+  std::vector<double> genome = random_vector(c->weight_count());
+  inc->set_base(genome);
+  compiled_net::context::ptr ctx = c->make_context();
+  std::vector<double> expected;
+  c->set_weights(*ctx, genome);
+  c->compute_batch(*ctx, input, expected);
+  ASSERT_EQ(expected.size(), inc->base_output().size());
+  for (size_t i = 0; i < expected.size(); ++i)
+    EXPECT_NEAR(expected[i], inc->base_output()[i], 1e-12);
+
+  std::vector<double> actual;
+  for (size_t g = 0; g < genome.size(); g += 3) {
+    std::vector<double> changed = genome;
+    changed[g] += 0.75;
+    c->set_weights(*ctx, changed);
+    c->compute_batch(*ctx, input, expected);
+    inc->evaluate_change(g, changed[g], actual);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-9);
+  }
+
+  // Accepted changes move the base; later changes build on them.
+  for (size_t g = 1; g < genome.size(); g += 5) {
+    genome[g] -= 0.5;
+    inc->accept_change(g, genome[g]);
+  }
+  EXPECT_EQ(genome, inc->get_base());
+  c->set_weights(*ctx, genome);
+  c->compute_batch(*ctx, input, expected);
+  for (size_t i = 0; i < expected.size(); ++i)
+    EXPECT_NEAR(expected[i], inc->base_output()[i], 1e-9);
+}
+}
+
+TEST(incremental_net, dense_changes_match_full_evaluation) {
+  neural_net::ptr net = make_banded_net(4, 6, 2, false);
+  expect_changes_match(net->compile());
+}
+
+TEST(incremental_net, sparse_changes_match_full_evaluation) {
+  neural_net::ptr net = make_banded_net(40, 12, 3, true);
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  ASSERT_TRUE(c->get_layer(1).blocks[0].sparse);
+  expect_changes_match(c);
+}
+
+TEST(incremental_net, fused_genes_fall_back_to_full_evaluation) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 3);
+  layer::ptr linear_layer(new layer);
+  linear_layer->add_neurons(linear_neuron_factory(), 5);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(sigmoid_neuron_factory(), 2);
+  linear_layer->connect_back(input_layer, internal_connector());
+  output_layer->connect_back(linear_layer, internal_connector());
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(linear_layer);
+  net->add_layer(output_layer);
+
+  compiled_net::ptr c = net->compile(true);
+  ASSERT_TRUE(c);
+  ASSERT_FALSE(c->get_layer(1).computed);
+  expect_changes_match(c);
+}
+
+TEST(incremental_net, recurrent_net_is_rejected) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 2);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), 2);
+  layer::ptr feedback_layer(new layer);
+  feedback_layer->add_neurons(feedback_neuron_factory(), 2);
+  hidden_layer->connect_back(input_layer, internal_connector());
+  hidden_layer->connect_back(feedback_layer, internal_connector());
+  feedback_layer->connect_back(hidden_layer, feedback_connector());
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(feedback_layer);
+
+  compiled_net::ptr c = net->compile();
+  ASSERT_TRUE(c);
+  EXPECT_FALSE(incremental_net::create(c, random_vector(4)));
+}
@@ -0,0 +1,123 @@
+#include <cstdlib>
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "island.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class test_genotype : public genotype<double> {
+public:
+  typedef std::shared_ptr<test_genotype> ptr;
+  explicit test_genotype(double value) : genotype<double>(value) {}
+  virtual double fitness() { return m_data; }
+};
+
+typedef rb_population<test_genotype> test_population;
+typedef b_selection<test_population> test_selection;
+
+// Copies every parent, so only migration changes the populations.
+class copy_crossover : public crossover<test_genotype> {
+public:
+  typedef std::shared_ptr<copy_crossover> ptr;
+  virtual std::vector<test_genotype::ptr> cross(
+    const std::vector<test_genotype::ptr> &p) {
+    std::vector<test_genotype::ptr> children;
+    for (size_t i = 0; i < p.size(); ++i)
+      children.push_back(test_genotype::ptr(new test_genotype(*p[i])));
+    return children;
+  }
+};
+
+class keep_mutation : public mutation<test_genotype> {
+public:
+  typedef std::shared_ptr<keep_mutation> ptr;
+  virtual test_genotype::ptr mutate(test_genotype::ptr g) { return g; }
+};
+
+typedef island_model<test_population, test_selection, copy_crossover,
+                     keep_mutation> test_model;
+
+// Island i holds genotypes 10 * (i + 1) .. 10 * (i + 1) + 7; island 0 also
+// holds a champion of fitness -1 in place of its worst genotype.
+test_model::ptr make_model(migration_topology topology) {
+  test_model::ptr model(new test_model(topology, 1, 1, 7));
+  for (size_t i = 0; i < 4; ++i) {
+    test_population::ptr p(new test_population);
+    for (size_t k = 0; k < 8; ++k)
+      p->insert(test_genotype::ptr(new test_genotype(10.0 * (i + 1) + k)));
+    if (i == 0) {
+      p->take_monster();
+      p->insert(test_genotype::ptr(new test_genotype(-1.0)));
+    }
+    model->add_island(p, test_selection::ptr(new test_selection),
+                      copy_crossover::ptr(new copy_crossover),
+                      keep_mutation::ptr(new keep_mutation));
+  }
+  return model;
+}
+
+bool has_champion(test_population::ptr p) {
+  test_genotype::ptr best = p->take_beauty();
+  p->insert(best);
+  return best->fitness() == -1.0;
+}
+}
+
+TEST(mailbox, collects_every_post_in_order) {
+  mailbox<size_t> box;
+  std::vector<std::thread> producers;
+  for (size_t t = 0; t < 4; ++t)
+    producers.push_back(std::thread([&box, t] {
+      for (size_t i = 0; i < 1000; ++i)
+        box.post(t * 1000 + i);
+    }));
+
+  std::vector<size_t> received;
+  while (received.size() < 4000)
+    box.collect(received);
+  for (size_t t = 0; t < producers.size(); ++t)
+    producers[t].join();
+
+  std::vector<size_t> last(4, 0);
+  std::vector<bool> seen(4000, false);
+  for (size_t i = 0; i < received.size(); ++i) {
+    size_t t = received[i] / 1000;
+    EXPECT_FALSE(seen[received[i]]);
+    seen[received[i]] = true;
+    EXPECT_GE(received[i] % 1000 + 1, last[t]);
+    last[t] = received[i] % 1000 + 1;
+  }
+}
+
+TEST(island_model, ring_sends_to_the_next_island) {
+  test_model::ptr model = make_model(ring_topology);
+  model->run(3);
+  EXPECT_TRUE(has_champion(model->get_population(0)));
+  EXPECT_TRUE(has_champion(model->get_population(1)));
+  for (size_t i = 0; i < model->island_count(); ++i)
+    EXPECT_EQ(8u, model->get_population(i)->count());
+  EXPECT_EQ(-1.0, model->best()->fitness());
+}
+
+TEST(island_model, full_topology_reaches_every_island) {
+  test_model::ptr model = make_model(full_topology);
+  model->run(1);
+  for (size_t i = 0; i < model->island_count(); ++i) {
+    EXPECT_TRUE(has_champion(model->get_population(i)));
+    EXPECT_EQ(8u, model->get_population(i)->count());
+  }
+}
+
+TEST(island_model, random_topology_sends_to_another_island) {
+  test_model::ptr model = make_model(random_topology);
+  model->run(1);
+  size_t reached = 0;
+  for (size_t i = 1; i < model->island_count(); ++i)
+    reached += has_champion(model->get_population(i));
+  EXPECT_GE(reached, 1u);
+  EXPECT_TRUE(has_champion(model->get_population(0)));
+}
@@ -0,0 +1,126 @@
+#include <cmath>
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kernel.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+std::vector<const kernels *> vector_kernels() {
+  std::vector<const kernels *> k;
+  if (sse2_supported())
+    k.push_back(sse2_kernels());
+  if (avx2_supported())
+    k.push_back(avx2_kernels());
+  if (avx512_supported())
+    k.push_back(avx512_kernels());
+  k.push_back(&best_kernels());
+  return k;
+}
+
+const double tolerance = 1e-9;
+}
+
+TEST(kernel, gemv_matches_scalar) {
+  const kernels &ref = scalar_kernels();
+  std::vector<const kernels *> all = vector_kernels();
+  for (size_t rows = 0; rows < 10; ++rows) {
+    for (size_t cols = 0; cols < 20; ++cols) {
+      std::vector<double> w = random_vector(rows * cols + 1, 10.0);
+      std::vector<double> x = random_vector(cols + 1, 10.0);
+      std::vector<double> y0 = random_vector(rows + 1, 10.0);
+      std::vector<double> expected = y0;
+      ref.gemv(&w[0], rows, cols, &x[0], &expected[0]);
+      for (size_t k = 0; k < all.size(); ++k) {
+        std::vector<double> actual = y0;
+        all[k]->gemv(&w[0], rows, cols, &x[0], &actual[0]);
+        for (size_t r = 0; r <= rows; ++r)
+          EXPECT_NEAR(expected[r], actual[r], tolerance) << all[k]->name;
+      }
+    }
+  }
+}
+
+TEST(kernel, gemm_matches_scalar) {
+  const kernels &ref = scalar_kernels();
+  std::vector<const kernels *> all = vector_kernels();
+  for (size_t count = 0; count < 9; ++count) {
+    for (size_t cols = 1; cols < 18; cols += 3) {
+      const size_t rows = 5;
+      std::vector<double> w = random_vector(rows * cols, 10.0);
+      std::vector<double> x = random_vector(count * cols + 1, 10.0);
+      std::vector<double> y0 = random_vector(count * rows + 1, 10.0);
+      std::vector<double> expected = y0;
+      ref.gemm(&w[0], rows, cols, &x[0], count, &expected[0]);
+      for (size_t k = 0; k < all.size(); ++k) {
+        std::vector<double> actual = y0;
+        all[k]->gemm(&w[0], rows, cols, &x[0], count, &actual[0]);
+        for (size_t i = 0; i < actual.size(); ++i)
+          EXPECT_NEAR(expected[i], actual[i], tolerance) << all[k]->name;
+      }
+    }
+  }
+}
+
+TEST(kernel, sparse_products_match_dense) {
+  std::vector<const kernels *> all = vector_kernels();
+  all.push_back(&scalar_kernels());
+  const size_t rows = 7;
+  const size_t cols = 23;
+  const size_t count = 5;
+  std::vector<double> dense(rows * cols, 0.0);
+  std::vector<size_t> row(1, 0);
+  std::vector<size_t> col;
+  std::vector<double> w;
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      if (std::rand() % (r + 1) != 0)
+        continue;
+      dense[r * cols + c] = (std::rand() % 2001) / 100.0 - 10.0;
+      w.push_back(dense[r * cols + c]);
+      col.push_back(c);
+    }
+    row.push_back(col.size());
+  }
+  std::vector<double> x = random_vector(count * cols, 10.0);
+  std::vector<double> y0 = random_vector(count * rows, 10.0);
+  std::vector<double> expected = y0;
+  scalar_kernels().gemm(&dense[0], rows, cols, &x[0], count, &expected[0]);
+  for (size_t k = 0; k < all.size(); ++k) {
+    std::vector<double> actual = y0;
+    all[k]->spmm(&w[0], &row[0], &col[0], rows, cols, &x[0], count,
+                 &actual[0]);
+    for (size_t i = 0; i < actual.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], tolerance) << all[k]->name;
+    actual = y0;
+    all[k]->spmv(&w[0], &row[0], &col[0], rows, &x[0], &actual[0]);
+    for (size_t i = 0; i < rows; ++i)
+      EXPECT_NEAR(expected[i], actual[i], tolerance) << all[k]->name;
+  }
+}
+
+TEST(kernel, activations_match_scalar) {
+  const kernels &ref = scalar_kernels();
+  std::vector<const kernels *> all = vector_kernels();
+  for (size_t n = 0; n < 35; ++n) {
+    std::vector<double> z = random_vector(n + 1, 10.0);
+    std::vector<double> expected(n + 1, 7.0);
+    ref.softsign(&z[0], n, &expected[0]);
+    for (size_t i = 0; i < n; ++i)
+      EXPECT_DOUBLE_EQ(z[i] / (1 + std::abs(z[i])), expected[i]);
+    for (size_t k = 0; k < all.size(); ++k) {
+      std::vector<double> actual(n + 1, 7.0);
+      all[k]->softsign(&z[0], n, &actual[0]);
+      for (size_t i = 0; i <= n; ++i)
+        EXPECT_NEAR(expected[i], actual[i], tolerance) << all[k]->name;
+      all[k]->linear(&z[0], n, &actual[0]);
+      for (size_t i = 0; i < n; ++i)
+        EXPECT_EQ(z[i], actual[i]) << all[k]->name;
+      EXPECT_EQ(7.0, actual[n]) << all[k]->name;
+    }
+  }
+}
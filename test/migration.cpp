@@ -0,0 +1,263 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "genome_codec.hpp"
+#include "migration_node.hpp"
+#include "process_island.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class test_genotype : public genotype<std::vector<double> > {
+public:
+  typedef std::shared_ptr<test_genotype> ptr;
+  explicit test_genotype(const std::vector<double> &data) :
+    genotype<std::vector<double> >(data) {}
+  virtual double fitness() { return m_data[0]; }
+};
+
+typedef rb_population<test_genotype> test_population;
+typedef b_selection<test_population> test_selection;
+
+class copy_crossover : public crossover<test_genotype> {
+public:
+  typedef std::shared_ptr<copy_crossover> ptr;
+  virtual std::vector<test_genotype::ptr> cross(
+    const std::vector<test_genotype::ptr> &p) {
+    std::vector<test_genotype::ptr> children;
+    for (size_t i = 0; i < p.size(); ++i)
+      children.push_back(test_genotype::ptr(new test_genotype(*p[i])));
+    return children;
+  }
+};
+
+class keep_mutation : public mutation<test_genotype> {
+public:
+  typedef std::shared_ptr<keep_mutation> ptr;
+  virtual test_genotype::ptr mutate(test_genotype::ptr g) { return g; }
+};
+
+typedef process_island<test_population, test_selection, copy_crossover,
+                       keep_mutation> test_island;
+
+std::string socket_path(const std::string &name) {
+  return "unix:/tmp/ga4nn-" + std::to_string(getpid()) + "-" + name;
+}
+
+test_genotype::ptr make_genotype(const std::vector<double> &data) {
+  return test_genotype::ptr(new test_genotype(data));
+}
+
+// Migrants arrive with the fitness their sender computed.
+test_genotype::ptr make_migrant(const std::vector<double> &data,
+                                double fitness) {
+  if (data.empty() || fitness != data[0])
+    return test_genotype::ptr();
+  return make_genotype(data);
+}
+
+bool has_champion(test_population::ptr p) {
+  test_genotype::ptr best = p->take_beauty();
+  p->insert(best);
+  return best->fitness() == -1.0;
+}
+
+void expect_exchange(migration_node::ptr from, migration_node::ptr to) {
+  ASSERT_TRUE(from);
+  ASSERT_TRUE(to);
+  ASSERT_TRUE(from->connect(to->address(), 1000));
+  EXPECT_EQ(1u, from->peer_count());
+
+  std::vector<unsigned char> first(3, 7), second(100000, 9);
+  from->send(first);
+  from->send(std::vector<unsigned char>());
+  from->send(second);
+
+  std::vector<std::vector<unsigned char> > frames;
+  for (size_t wait = 0; wait < 500 && frames.size() < 3; ++wait) {
+    to->receive(frames);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  ASSERT_EQ(3u, frames.size());
+  EXPECT_EQ(first, frames[0]);
+  EXPECT_TRUE(frames[1].empty());
+  EXPECT_EQ(second, frames[2]);
+}
+
+// Island index of a ring of three listening on base + index. Every
+// island stays up until its predecessor has reached it, so no island
+// leaves before its neighbour connected; island 1 must have received the
+// champion of island 0.
+int ring_worker(const std::string &base, size_t index) {
+  migration_node::ptr node =
+    migration_node::create(base + std::to_string(index));
+  if (!node || !node->connect(base + std::to_string((index + 1) % 3)))
+    return 2;
+
+  test_population::ptr p(new test_population);
+  for (size_t k = 0; k < 6; ++k)
+    p->insert(make_genotype(std::vector<double>(4, 10.0 * (index + 1) + k)));
+  if (index == 0)
+    p->insert(make_genotype(std::vector<double>(4, -1.0)));
+
+  test_island island(node, 1, 1, make_migrant);
+  size_t arrived = island.run(p, test_selection::ptr(new test_selection),
+                              copy_crossover::ptr(new copy_crossover),
+                              keep_mutation::ptr(new keep_mutation), 3);
+  for (size_t wait = 0; arrived == 0 && wait < 500; ++wait) {
+    arrived += island.immigrate(p);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (arrived == 0 || !node->flush())
+    return 3;
+  return index == 1 && !has_champion(p) ? 1 : 0;
+}
+}
+
+TEST(genome_codec, round_trips_genomes) {
+  std::vector<double> genes, fitness;
+  for (size_t i = 0; i < 15; ++i)
+    genes.push_back(i * 0.5 - 3.25);
+  fitness.push_back(1.5);
+  fitness.push_back(-2.0);
+  fitness.push_back(1e300);
+
+  std::vector<unsigned char> block;
+  encode_genomes(genes, 5, fitness, block);
+  EXPECT_EQ(16u + 3 * 6 * 8, block.size());
+  EXPECT_EQ('G', block[0]);
+
+  std::vector<double> genes_out, fitness_out;
+  size_t width = 0;
+  ASSERT_TRUE(decode_genomes(&block[0], block.size(), genes_out, width,
+                             fitness_out));
+  EXPECT_EQ(5u, width);
+  EXPECT_EQ(genes, genes_out);
+  EXPECT_EQ(fitness, fitness_out);
+
+  EXPECT_FALSE(decode_genomes(&block[0], block.size() - 1, genes_out, width,
+                              fitness_out));
+  EXPECT_TRUE(genes_out.empty());
+  block[0] = 'X';
+  EXPECT_FALSE(decode_genomes(&block[0], block.size(), genes_out, width,
+                              fitness_out));
+}
+
+TEST(migration_node, exchanges_frames_over_unix_sockets) {
+  expect_exchange(migration_node::create(socket_path("a")),
+                  migration_node::create(socket_path("b")));
+}
+
+TEST(migration_node, exchanges_frames_over_tcp) {
+  migration_node::ptr to = migration_node::create("tcp:127.0.0.1:0");
+  ASSERT_TRUE(to);
+  EXPECT_NE("tcp:127.0.0.1:0", to->address());
+  expect_exchange(migration_node::create("tcp:127.0.0.1:0"), to);
+}
+
+// Both neighbours send a frame far larger than a socket buffer before
+// either reads, as a ring of islands does; neither may wait for the other.
+TEST(migration_node, large_frames_do_not_block) {
+  migration_node::ptr a = migration_node::create(socket_path("big-a"));
+  migration_node::ptr b = migration_node::create(socket_path("big-b"));
+  ASSERT_TRUE(a);
+  ASSERT_TRUE(b);
+  ASSERT_TRUE(a->connect(b->address(), 1000));
+  ASSERT_TRUE(b->connect(a->address(), 1000));
+
+  std::vector<unsigned char> big(8 << 20);
+  for (size_t i = 0; i < big.size(); ++i)
+    big[i] = static_cast<unsigned char>(i * 31 + i / 4096);
+  a->send(big);
+  b->send(big);
+  EXPECT_GT(a->pending(), 0u);
+
+  std::vector<std::vector<unsigned char> > to_a, to_b;
+  for (size_t wait = 0; wait < 5000 && (to_a.empty() || to_b.empty());
+       ++wait) {
+    a->receive(to_a);
+    b->receive(to_b);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(1u, to_a.size());
+  ASSERT_EQ(1u, to_b.size());
+  EXPECT_TRUE(big == to_a[0]);
+  EXPECT_TRUE(big == to_b[0]);
+  EXPECT_TRUE(a->flush(1000));
+  EXPECT_EQ(0u, a->pending());
+
+  // Too large for the reader to take: refused without cutting a off.
+  EXPECT_FALSE(a->send(std::vector<unsigned char>(
+    migration_node::max_frame_size() + 1)));
+  EXPECT_EQ(0u, a->pending());
+  EXPECT_EQ(1u, a->peer_count());
+  EXPECT_TRUE(a->send(std::vector<unsigned char>(3, 1)));
+  to_b.clear();
+  for (size_t wait = 0; wait < 500 && to_b.empty(); ++wait) {
+    b->receive(to_b);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(1u, to_b.size());
+  EXPECT_EQ(std::vector<unsigned char>(3, 1), to_b[0]);
+}
+
+TEST(migration_node, rejects_bad_addresses) {
+  EXPECT_FALSE(migration_node::create("udp:127.0.0.1:1"));
+  EXPECT_FALSE(migration_node::create("unix:"));
+
+  std::string file = socket_path("file").substr(5);
+  FILE *f = std::fopen(file.c_str(), "w");
+  ASSERT_TRUE(f);
+  std::fclose(f);
+  EXPECT_FALSE(migration_node::create("unix:" + file));
+  EXPECT_EQ(0, access(file.c_str(), F_OK));
+  unlink(file.c_str());
+}
+
+TEST(migration_node, replaces_only_stale_sockets) {
+  std::string address = socket_path("taken");
+  migration_node::ptr live = migration_node::create(address);
+  ASSERT_TRUE(live);
+  EXPECT_FALSE(migration_node::create(address));
+  migration_node::ptr peer = migration_node::create(socket_path("peer"));
+  ASSERT_TRUE(peer);
+  EXPECT_TRUE(peer->connect(address, 1000));
+
+  // Left behind by a process that died without cleaning up.
+  std::string path = socket_path("stale").substr(5);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un un;
+  std::memset(&un, 0, sizeof(un));
+  un.sun_family = AF_UNIX;
+  std::strcpy(un.sun_path, path.c_str());
+  ASSERT_EQ(0, bind(fd, reinterpret_cast<sockaddr *>(&un), sizeof(un)));
+  close(fd);
+  migration_node::ptr replacing = migration_node::create("unix:" + path);
+  EXPECT_TRUE(replacing);
+
+  // A node does not remove a socket file that is no longer its own.
+  unlink(path.c_str());
+  migration_node::ptr successor = migration_node::create("unix:" + path);
+  ASSERT_TRUE(successor);
+  replacing.reset();
+  EXPECT_EQ(0, access(path.c_str(), F_OK));
+}
+
+TEST(process_island, migrants_cross_processes) {
+  const std::string base = socket_path("ring");
+  EXPECT_TRUE(launch_workers(3, [&base](size_t index) {
+    return ring_worker(base, index);
+  }));
+  EXPECT_FALSE(launch_workers(2, [](size_t index) { return int(index); }));
+}
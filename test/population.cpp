@@ -0,0 +1,226 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "genetic.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class scored_genotype : public genotype<size_t> {
+public:
+  typedef std::shared_ptr<scored_genotype> ptr;
+  scored_genotype(size_t id, double fitness) :
+    genotype<size_t>(id), m_fitval(fitness) {}
+  virtual double fitness() { return m_fitval; }
+
+private:
+  double m_fitval;
+};
+
+typedef rb_population<scored_genotype> tree_population;
+typedef flat_population<scored_genotype> vector_population;
+typedef ranked_population<scored_genotype> rank_population;
+
+size_t id_of(const scored_genotype::ptr &g) {
+  return g ? g->get_data() : size_t(-1);
+}
+
+// One child per parent, halfway between it and its partner.
+class average_crossover : public crossover<scored_genotype> {
+public:
+  typedef std::shared_ptr<average_crossover> ptr;
+  virtual std::vector<scored_genotype::ptr> cross(
+    const std::vector<scored_genotype::ptr> &p) {
+    std::vector<scored_genotype::ptr> children;
+    for (size_t c = 0; c < p.size(); ++c) {
+      double fitness = 0.5 * (p[c]->fitness() +
+                              p[p.size() - 1 - c]->fitness());
+      children.push_back(scored_genotype::ptr(
+        new scored_genotype(p[c]->get_data(), fitness)));
+    }
+    return children;
+  }
+};
+
+class keep_mutation : public mutation<scored_genotype> {
+public:
+  typedef std::shared_ptr<keep_mutation> ptr;
+  virtual scored_genotype::ptr mutate(scored_genotype::ptr g) { return g; }
+};
+
+class epoch_stop : public stop_function<rank_population> {
+public:
+  typedef std::shared_ptr<epoch_stop> ptr;
+  explicit epoch_stop(size_t epochs) : m_epochs(epochs) {}
+  virtual bool done(rank_population::ptr) { return m_epochs-- == 0; }
+
+private:
+  size_t m_epochs;
+};
+
+template<class Selection>
+double mean_after(typename Selection::ptr selection, size_t &count) {
+  rank_population::ptr p(new rank_population);
+  for (size_t i = 0; i < 200; ++i)
+    p->insert(scored_genotype::ptr(new scored_genotype(i, i)));
+  average_crossover::ptr cross(new average_crossover);
+  keep_mutation::ptr mutate(new keep_mutation);
+  epoch_stop::ptr stop(new epoch_stop(5));
+  rank_population::ptr result =
+    evolve<rank_population, Selection, average_crossover, keep_mutation,
+           epoch_stop>(p, selection, cross, mutate, stop);
+  count = result->count();
+  double sum = 0.0;
+  for (size_t k = 0; k < count; ++k)
+    sum += result->select_kth(k)->fitness();
+  return sum / count;
+}
+}
+
+TEST(flat_population, empty) {
+  vector_population p;
+  EXPECT_EQ(0u, p.count());
+  EXPECT_FALSE(p.take_beauty());
+  EXPECT_FALSE(p.take_monster());
+  EXPECT_FALSE(p.take_middle());
+}
+
+TEST(flat_population, order) {
+  vector_population p;
+  double fitness[] = {3.0, 1.0, 2.0, 5.0, 4.0};
+  for (size_t i = 0; i < 5; ++i)
+    p.insert(scored_genotype::ptr(new scored_genotype(i, fitness[i])));
+  EXPECT_EQ(5u, p.count());
+  EXPECT_EQ(1u, id_of(p.take_beauty()));
+  EXPECT_EQ(3u, id_of(p.take_monster()));
+  EXPECT_EQ(0u, id_of(p.take_middle()));
+  EXPECT_EQ(2u, p.count());
+  p.clear();
+  EXPECT_EQ(0u, p.count());
+}
+
+// Interleaved inserts and takes, with many ties, must yield exactly what
+// the multimap-backed population yields.
+TEST(flat_population, matches_rb_population) {
+  tree_population tree;
+  vector_population flat;
+  unsigned seed = 7;
+  size_t id = 0;
+  for (size_t step = 0; step < 5000; ++step) {
+    seed = seed * 1103515245 + 12345;
+    unsigned r = (seed >> 16) % 10;
+    if (r < 5 || tree.count() == 0) {
+      double fitness = static_cast<double>((seed >> 20) % 16);
+      tree.insert(scored_genotype::ptr(new scored_genotype(id, fitness)));
+      flat.insert(scored_genotype::ptr(new scored_genotype(id, fitness)));
+      ++id;
+    } else if (r < 7) {
+      EXPECT_EQ(id_of(tree.take_beauty()), id_of(flat.take_beauty()));
+    } else if (r < 9) {
+      EXPECT_EQ(id_of(tree.take_monster()), id_of(flat.take_monster()));
+    } else {
+      EXPECT_EQ(id_of(tree.take_middle()), id_of(flat.take_middle()));
+    }
+    ASSERT_EQ(tree.count(), flat.count());
+  }
+  while (tree.count() > 0)
+    EXPECT_EQ(id_of(tree.take_beauty()), id_of(flat.take_beauty()));
+  EXPECT_EQ(0u, flat.count());
+}
+
+TEST(ranked_population, matches_rb_population) {
+  tree_population tree;
+  rank_population ranked;
+  unsigned seed = 11;
+  size_t id = 0;
+  for (size_t step = 0; step < 5000; ++step) {
+    seed = seed * 1103515245 + 12345;
+    unsigned r = (seed >> 16) % 10;
+    if (r < 5 || tree.count() == 0) {
+      double fitness = static_cast<double>((seed >> 20) % 16);
+      tree.insert(scored_genotype::ptr(new scored_genotype(id, fitness)));
+      ranked.insert(scored_genotype::ptr(new scored_genotype(id, fitness)));
+      ++id;
+    } else if (r < 7) {
+      EXPECT_EQ(id_of(tree.take_beauty()), id_of(ranked.take_beauty()));
+    } else if (r < 9) {
+      EXPECT_EQ(id_of(tree.take_monster()), id_of(ranked.take_monster()));
+    } else {
+      EXPECT_EQ(id_of(tree.take_middle()), id_of(ranked.take_middle()));
+    }
+    ASSERT_EQ(tree.count(), ranked.count());
+  }
+  while (tree.count() > 0)
+    EXPECT_EQ(id_of(tree.take_beauty()), id_of(ranked.take_beauty()));
+  EXPECT_EQ(0u, ranked.count());
+}
+
+TEST(ranked_population, order_statistics) {
+  rank_population p;
+  EXPECT_FALSE(p.select_kth(0));
+  EXPECT_FALSE(p.take_monster());
+  EXPECT_EQ(0u, p.rank_of(1.0));
+  // Fitness 2 * (i % 50) puts ids i and i + 50 next to each other.
+  for (size_t i = 0; i < 100; ++i)
+    p.insert(scored_genotype::ptr(new scored_genotype(i, 2.0 * (i % 50))));
+  ASSERT_EQ(100u, p.count());
+  for (size_t k = 0; k < 100; ++k)
+    EXPECT_EQ(k / 2 + (k % 2) * 50, id_of(p.select_kth(k)));
+  EXPECT_FALSE(p.select_kth(100));
+  EXPECT_EQ(0u, p.rank_of(0.0));
+  EXPECT_EQ(2u, p.rank_of(1.0));
+  EXPECT_EQ(20u, p.rank_of(20.0));
+  EXPECT_EQ(100u, p.rank_of(1000.0));
+  EXPECT_EQ(0u, id_of(p.percentile(0.0)));
+  EXPECT_EQ(25u, id_of(p.percentile(0.5)));
+  EXPECT_EQ(99u, id_of(p.percentile(1.0)));
+
+  EXPECT_EQ(60u, id_of(p.take_kth(21)));
+  EXPECT_EQ(99u, p.count());
+  EXPECT_EQ(11u, id_of(p.select_kth(21)));
+  EXPECT_EQ(20u, p.rank_of(20.0));
+  EXPECT_EQ(21u, p.rank_of(21.0));
+
+  // Copies are independent.
+  rank_population q(p);
+  q.take_beauty();
+  EXPECT_EQ(99u, p.count());
+  EXPECT_EQ(0u, id_of(p.select_kth(0)));
+  EXPECT_EQ(50u, id_of(q.select_kth(0)));
+}
+
+TEST(ranked_population, linear_ranking_draws) {
+  rank_population p;
+  for (size_t i = 0; i < 10; ++i)
+    p.insert(scored_genotype::ptr(new scored_genotype(i, i)));
+  std::vector<size_t> uniform(10), ranked(10);
+  for (size_t i = 0; i < 10000; ++i) {
+    double u = (i + 0.5) / 10000;
+    ++uniform[id_of(p.sample(u, 1.0))];
+    ++ranked[id_of(p.sample(u, 2.0))];
+  }
+  // Pressure 2 gives rank r a weight of 2 * (10 - r) - 1 in 100.
+  for (size_t r = 0; r < 10; ++r) {
+    EXPECT_NEAR(1000.0, uniform[r], 1.0);
+    EXPECT_NEAR(100.0 * (19 - 2 * r), ranked[r], 30.0);
+  }
+  EXPECT_EQ(10u, p.count());
+}
+
+TEST(ranked_population, ranking_selections_evolve) {
+  typedef linear_ranking_selection<rank_population> linear;
+  typedef truncation_selection<rank_population> truncation;
+  size_t count = 0;
+  double neutral = mean_after<linear>(linear::ptr(new linear(1.0)), count);
+  EXPECT_EQ(200u, count);
+  double pressed = mean_after<linear>(linear::ptr(new linear(2.0)), count);
+  EXPECT_EQ(200u, count);
+  double truncated =
+    mean_after<truncation>(truncation::ptr(new truncation(0.25)), count);
+  EXPECT_EQ(200u, count);
+  EXPECT_NEAR(99.5, neutral, 15.0);
+  EXPECT_LT(pressed, neutral - 30.0);
+  EXPECT_LT(truncated, pressed);
+}
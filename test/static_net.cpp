@@ -0,0 +1,58 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "static_net.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+template <class Factory>
+layer::ptr make_layer(size_t size, const layer::ptr &back) {
+  layer::ptr l(new layer);
+  l->add_neurons(Factory(), size);
+  if (back)
+    l->connect_back(back, internal_connector());
+  return l;
+}
+}
+
+TEST(static_net, weight_count_is_constant) {
+  static_assert(static_net<2, 4, 1>::weight_count == 12, "2-4-1");
+  static_assert(static_net<3, 5, 4, 2>::weight_count == 43, "3-5-4-2");
+  static_assert(static_net<3, 5, 4, 2>::output_count == 2, "outputs");
+}
+
+TEST(static_net, compute_matches_neural_net) {
+  layer::ptr input_layer = make_layer<input_neuron_factory>(3, layer::ptr());
+  layer::ptr first = make_layer<sigmoid_neuron_factory>(5, input_layer);
+  layer::ptr second = make_layer<sigmoid_neuron_factory>(4, first);
+  layer::ptr output_layer = make_layer<output_neuron_factory>(2, second);
+  neural_net net;
+  net.add_layer(input_layer);
+  net.add_layer(first);
+  net.add_layer(second);
+  net.add_layer(output_layer);
+
+  typedef static_net<3, 5, 4, 2> fixed_net;
+  ASSERT_EQ(fixed_net::weight_count, net.get_weights().size());
+  std::vector<double> genome = random_vector(fixed_net::weight_count);
+  net.set_weights(genome);
+  fixed_net fixed;
+  fixed.set_weights(genome);
+  EXPECT_EQ(genome, fixed.get_weights());
+
+  for (size_t step = 0; step < 5; ++step) {
+    std::vector<double> input = random_vector(3);
+    fixed_net::input_type x = { { input[0], input[1], input[2] } };
+    std::vector<double> expected = net.compute(input);
+    fixed_net::output_type actual = fixed.compute(x);
+    for (size_t i = 0; i < 2; ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-12);
+  }
+}
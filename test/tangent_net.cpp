@@ -0,0 +1,148 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "tangent_net.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+// Outputs of every step of a rollout from a cleared state.
+std::vector<double> rollout(const compiled_net::ptr &c,
+                            const std::vector<double> &weights,
+                            const std::vector<double> &input) {
+  compiled_net::context::ptr ctx = c->make_context();
+  c->set_weights(*ctx, weights);
+  std::vector<double> output;
+  c->compute_batch(*ctx, input, output);
+  return output;
+}
+
+// Checks the tangents of a rollout against central differences of the
+// outputs along each direction.
+void expect_tangents_match(const compiled_net::ptr &c,
+                           const std::vector<double> &directions,
+                           size_t steps) {
+  const size_t genes = c->weight_count();
+  const size_t count = directions.size() / genes;
+  std::vector<double> weights = random_vector(genes);
+  std::vector<double> input = random_vector(steps * c->input_count());
+
+  tangent_net::ptr t = tangent_net::create(c, count);
+  ASSERT_TRUE(t);
+  t->set_weights(weights);
+  t->set_directions(directions);
+  const size_t outputs = c->output_count();
+  std::vector<double> output(outputs), tangent(count * outputs);
+  std::vector<double> values, tangents;
+  for (size_t s = 0; s < steps; ++s) {
+    EXPECT_EQ(outputs, t->compute(&input[s * c->input_count()], 0,
+                                  &output[0], &tangent[0]));
+    values.insert(values.end(), output.begin(), output.end());
+    tangents.insert(tangents.end(), tangent.begin(), tangent.end());
+  }
+  EXPECT_EQ(rollout(c, weights, input), values);
+
+  const double h = 1e-6;
+  for (size_t d = 0; d < count; ++d) {
+    std::vector<double> up = weights, down = weights;
+    for (size_t g = 0; g < genes; ++g) {
+      up[g] += h * directions[d * genes + g];
+      down[g] -= h * directions[d * genes + g];
+    }
+    std::vector<double> high = rollout(c, up, input);
+    std::vector<double> low = rollout(c, down, input);
+    for (size_t s = 0; s < steps; ++s)
+      for (size_t o = 0; o < outputs; ++o)
+        EXPECT_NEAR((high[s * outputs + o] - low[s * outputs + o]) / (2 * h),
+                    tangents[(s * count + d) * outputs + o], 1e-6);
+  }
+}
+}
+
+TEST(tangent_net, directional_derivatives_match_differences) {
+  neural_net::ptr net = make_net<sigmoid_neuron_factory>(3, 5, 2);
+  compiled_net::ptr c = net->compile();
+  expect_tangents_match(c, random_vector(3 * c->weight_count()), 4);
+}
+
+TEST(tangent_net, fused_blocks_are_differentiated) {
+  neural_net::ptr net =
+    make_net<linear_neuron_factory, sigmoid_neuron_factory>(3, 5, 2);
+  compiled_net::ptr fused = net->compile(true);
+  ASSERT_TRUE(fused);
+  ASSERT_FALSE(fused->get_layer(1).computed);
+  expect_tangents_match(fused, random_vector(3 * fused->weight_count()), 4);
+}
+
+TEST(tangent_net, tangents_follow_feedback_delays) {
+  compiled_net::ptr c = make_feedback_net()->compile();
+  ASSERT_TRUE(c);
+  ASSERT_FALSE(c->feedforward());
+  expect_tangents_match(c, random_vector(2 * c->weight_count()), 6);
+}
+
+TEST(tangent_net, seeded_genes_give_the_gradient) {
+  compiled_net::ptr c = make_feedback_net()->compile();
+  const size_t genes = c->weight_count();
+  std::vector<double> weights = random_vector(genes);
+  std::vector<double> input = random_vector(5 * c->input_count());
+
+  // Gradient of the sum of all outputs, four genes per rollout.
+  tangent_net::ptr t = tangent_net::create(c, 4);
+  t->set_weights(weights);
+  std::vector<double> gradient(genes);
+  std::vector<double> output(c->output_count());
+  std::vector<double> tangent(4 * c->output_count());
+  for (size_t first = 0; first < genes; first += 4) {
+    t->seed_genes(first);
+    t->reset();
+    for (size_t s = 0; s < 5; ++s) {
+      t->compute(&input[s * c->input_count()], 0, &output[0], &tangent[0]);
+      for (size_t d = 0; d < 4 && first + d < genes; ++d)
+        for (size_t o = 0; o < c->output_count(); ++o)
+          gradient[first + d] += tangent[d * c->output_count() + o];
+    }
+  }
+
+  const double h = 1e-6;
+  for (size_t g = 0; g < genes; ++g) {
+    std::vector<double> up = weights, down = weights;
+    up[g] += h;
+    down[g] -= h;
+    std::vector<double> high = rollout(c, up, input);
+    std::vector<double> low = rollout(c, down, input);
+    double expected = 0.0;
+    for (size_t i = 0; i < high.size(); ++i)
+      expected += (high[i] - low[i]) / (2 * h);
+    EXPECT_NEAR(expected, gradient[g], 1e-6);
+  }
+}
+
+TEST(tangent_net, input_tangents_are_propagated) {
+  compiled_net::ptr c = make_feedback_net()->compile();
+  tangent_net::ptr t = tangent_net::create(c, 1);
+  std::vector<double> weights = random_vector(c->weight_count());
+  t->set_weights(weights);
+  t->set_directions(std::vector<double>(c->weight_count(), 0.0));
+
+  // d output / d input[1] of a single step.
+  std::vector<double> input = random_vector(2);
+  double input_tangent[2] = {0.0, 1.0};
+  std::vector<double> output(2), tangent(2);
+  t->compute(&input[0], input_tangent, &output[0], &tangent[0]);
+
+  const double h = 1e-6;
+  std::vector<double> up = input, down = input;
+  up[1] += h;
+  down[1] -= h;
+  std::vector<double> high = rollout(c, weights, up);
+  std::vector<double> low = rollout(c, weights, down);
+  for (size_t o = 0; o < 2; ++o)
+    EXPECT_NEAR((high[o] - low[o]) / (2 * h), tangent[o], 1e-6);
+}
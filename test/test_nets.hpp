@@ -0,0 +1,67 @@
+#ifndef __TEST_NETS_HPP
+#define __TEST_NETS_HPP
+#include <cstdlib>
+
+#include <vector>
+
+#include "arena.hpp"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+
+// Values in [-scale, scale] in steps of scale / 1000.
+inline std::vector<double> random_vector(size_t size, double scale = 1.0) {
+  std::vector<double> v(size);
+  for (size_t i = 0; i < size; ++i)
+    v[i] = scale * ((std::rand() % 2001) / 1000.0 - 1.0);
+  return v;
+}
+
+// Fully connected inputs -> hidden -> outputs.
+template <class HiddenFactory, class OutputFactory = HiddenFactory>
+ga4nn::neural_net::ptr make_net(size_t inputs, size_t hidden,
+                                size_t outputs) {
+  using namespace ga4nn;
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), inputs);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(HiddenFactory(), hidden);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(OutputFactory(), outputs);
+  hidden_layer->connect_back(input_layer, internal_connector());
+  output_layer->connect_back(hidden_layer, internal_connector());
+
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(output_layer);
+  return net;
+}
+
+// A sigmoid layer fed back through a feedback layer, then an output layer.
+inline ga4nn::neural_net::ptr make_feedback_net(
+    size_t inputs = 2, size_t hidden = 3, size_t outputs = 2,
+    const ga4nn::arena::ptr &a = ga4nn::arena::ptr()) {
+  using namespace ga4nn;
+  layer::ptr input_layer(new layer(a));
+  input_layer->add_neurons(input_neuron_factory(), inputs);
+  layer::ptr hidden_layer(new layer(a));
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), hidden);
+  layer::ptr feedback_layer(new layer(a));
+  feedback_layer->add_neurons(feedback_neuron_factory(), hidden);
+  layer::ptr output_layer(new layer(a));
+  output_layer->add_neurons(output_neuron_factory(), outputs);
+  hidden_layer->connect_back(input_layer, internal_connector());
+  hidden_layer->connect_back(feedback_layer, internal_connector());
+  feedback_layer->connect_back(hidden_layer, feedback_connector());
+  output_layer->connect_back(hidden_layer, internal_connector());
+
+  neural_net::ptr net(new neural_net);
+  net->add_layer(input_layer);
+  net->add_layer(hidden_layer);
+  net->add_layer(feedback_layer);
+  net->add_layer(output_layer);
+  return net;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include <cstdlib>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "connector.hpp"
+#include "neural_net.hpp"
+#include "neuron_factory.hpp"
+#include "typed_net.hpp"
+#include "test_nets.hpp"
+
+using namespace ga4nn;
+
+namespace {
+class skip_connector {
+public:
+  bool valid_connection(size_t back_index, size_t front_index) {
+    return (back_index + front_index) % 3 != 0;
+  }
+  double weight() { return 0.5; }
+  bool constant() { return back_count++ % 2 == 0; }
+
+  size_t back_count = 0;
+};
+}
+
+TEST(typed_net, compute_matches_neural_net) {
+  layer::ptr input_layer(new layer);
+  input_layer->add_neurons(input_neuron_factory(), 3);
+  layer::ptr hidden_layer(new layer);
+  hidden_layer->add_neurons(sigmoid_neuron_factory(), 5);
+  layer::ptr output_layer(new layer);
+  output_layer->add_neurons(output_neuron_factory(), 2);
+  hidden_layer->connect_back(input_layer, internal_connector());
+  output_layer->connect_back(hidden_layer, skip_connector());
+  output_layer->connect_back(input_layer, internal_connector());
+  neural_net net;
+  net.add_layer(input_layer);
+  net.add_layer(hidden_layer);
+  net.add_layer(output_layer);
+
+  identity_layer::ptr typed_input(new identity_layer(3));
+  softsign_layer::ptr typed_hidden(new softsign_layer(5));
+  identity_layer::ptr typed_output(new identity_layer(2));
+  typed_hidden->connect_back(typed_input, internal_connector());
+  typed_output->connect_back(typed_hidden, skip_connector());
+  typed_output->connect_back(typed_input, internal_connector());
+  typed_net typed;
+  typed.add_layer(typed_input);
+  typed.add_layer(typed_hidden);
+  typed.add_layer(typed_output);
+
+  EXPECT_EQ(net.get_weights(), typed.get_weights());
+  std::vector<double> weights = random_vector(typed.weight_count());
+  ASSERT_EQ(net.get_weights().size(), weights.size());
+  net.set_weights(weights);
+  typed.set_weights(weights);
+  EXPECT_EQ(weights, typed.get_weights());
+
+  for (size_t step = 0; step < 5; ++step) {
+    std::vector<double> input = random_vector(3);
+    std::vector<double> expected = net.compute(input);
+    std::vector<double> actual = typed.compute(input);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_NEAR(expected[i], actual[i], 1e-12);
+  }
+}